@@ -0,0 +1,174 @@
+#include "game.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Opt-in heap tracking, built with -DTRACK_ALLOCATIONS (make track). Global operator new/delete
+// are replaced so every allocation is counted against the tag of the thread making it; the sim
+// thread and the main thread tag their own work. Counts, bytes and the peak of live memory are
+// collected per frame, shown in an overlay (F3) and logged once a second. Without the define the
+// functions below are no-ops and the default allocator is used.
+
+bool allocationAssertEnabled = false;
+
+#ifdef TRACK_ALLOCATIONS
+
+// Each block carries its size and tag in front so deletes can be charged back
+struct alignas(max_align_t) AllocationHeader {
+    size_t size;
+    AllocationTag tag;
+};
+
+static atomic<uint64_t> frameAllocationCounts[ALLOC_TAG_COUNT];
+static atomic<uint64_t> frameAllocationBytes[ALLOC_TAG_COUNT];
+static atomic<int64_t> liveAllocationBytes(0);
+static atomic<int64_t> framePeakBytes(0);
+static thread_local AllocationTag currentAllocationTag = ALLOC_OTHER;
+
+static void* TrackedAllocate(size_t size) {
+    void* block = malloc(sizeof(AllocationHeader) + size);
+    if (block == nullptr) return nullptr;
+    AllocationHeader* header = (AllocationHeader*)block;
+    header->size = size;
+    header->tag = currentAllocationTag;
+    frameAllocationCounts[header->tag].fetch_add(1, memory_order_relaxed);
+    frameAllocationBytes[header->tag].fetch_add(size, memory_order_relaxed);
+    int64_t live = liveAllocationBytes.fetch_add((int64_t)size, memory_order_relaxed) + (int64_t)size;
+    int64_t peak = framePeakBytes.load(memory_order_relaxed);
+    while (live > peak && !framePeakBytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {}
+    return header + 1;
+}
+
+static void TrackedFree(void* pointer) {
+    if (pointer == nullptr) return;
+    AllocationHeader* header = (AllocationHeader*)pointer - 1;
+    liveAllocationBytes.fetch_sub((int64_t)header->size, memory_order_relaxed);
+    free(header);
+}
+
+void* operator new(size_t size) {
+    void* pointer = TrackedAllocate(size);
+    if (pointer == nullptr) throw bad_alloc();
+    return pointer;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    return TrackedAllocate(size);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    return TrackedAllocate(size);
+}
+
+void operator delete(void* pointer) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { TrackedFree(pointer); }
+void operator delete(void* pointer, const nothrow_t&) noexcept { TrackedFree(pointer); }
+void operator delete[](void* pointer, const nothrow_t&) noexcept { TrackedFree(pointer); }
+
+static const char* allocationTagNames[ALLOC_TAG_COUNT] = {
+    "other", "paths", "enemies", "towers", "effects", "waves", "snapshot", "draw", "hud",
+};
+
+static AllocationFrameStats lastFrameStats;
+static AllocationFrameStats secondStats; // Summed over the frames since the last log line
+static int secondFrames = 0;
+static double secondStart = 0.0;
+static int trackedFrames = 0;
+static bool showAllocationOverlay = false;
+
+void SetAllocationTag(AllocationTag tag) {
+    currentAllocationTag = tag;
+}
+
+void BeginAllocationFrame() {
+    for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+        frameAllocationCounts[tag].store(0, memory_order_relaxed);
+        frameAllocationBytes[tag].store(0, memory_order_relaxed);
+    }
+    framePeakBytes.store(liveAllocationBytes.load(memory_order_relaxed), memory_order_relaxed);
+}
+
+bool EndAllocationFrame() {
+    // Returns false when the assertion mode is on and a frame past warm-up allocated
+    AllocationFrameStats& stats = lastFrameStats;
+    stats.totalCount = 0;
+    stats.totalBytes = 0;
+    for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+        stats.counts[tag] = frameAllocationCounts[tag].load(memory_order_relaxed);
+        stats.bytes[tag] = frameAllocationBytes[tag].load(memory_order_relaxed);
+        stats.totalCount += stats.counts[tag];
+        stats.totalBytes += stats.bytes[tag];
+        secondStats.counts[tag] += stats.counts[tag];
+        secondStats.bytes[tag] += stats.bytes[tag];
+    }
+    stats.liveBytes = liveAllocationBytes.load(memory_order_relaxed);
+    stats.peakBytes = framePeakBytes.load(memory_order_relaxed);
+    secondStats.totalCount += stats.totalCount;
+    secondStats.totalBytes += stats.totalBytes;
+    secondStats.peakBytes = max(secondStats.peakBytes, stats.peakBytes);
+    secondFrames++;
+    trackedFrames++;
+
+    if (IsKeyPressed(KEY_F3)) showAllocationOverlay = !showAllocationOverlay;
+    if (GetTime() - secondStart >= 1.0) {
+        TraceLog(LOG_INFO, "ALLOC: %d frames, %llu allocations (%llu bytes), live %lld, peak %lld",
+                 secondFrames, (unsigned long long)secondStats.totalCount, (unsigned long long)secondStats.totalBytes,
+                 (long long)stats.liveBytes, (long long)secondStats.peakBytes);
+        for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+            if (secondStats.counts[tag] == 0) continue;
+            TraceLog(LOG_INFO, "ALLOC:   %-8s %llu allocations, %llu bytes", allocationTagNames[tag],
+                     (unsigned long long)secondStats.counts[tag], (unsigned long long)secondStats.bytes[tag]);
+        }
+        secondStats = {};
+        secondFrames = 0;
+        secondStart = GetTime();
+    }
+
+    if (!allocationAssertEnabled || trackedFrames <= allocationWarmupFrames || stats.totalCount == 0) return true;
+    for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+        if (stats.counts[tag] == 0) continue;
+        TraceLog(LOG_ERROR, "ALLOC: steady-state frame %d allocated %llu times (%llu bytes) in %s", trackedFrames,
+                 (unsigned long long)stats.counts[tag], (unsigned long long)stats.bytes[tag], allocationTagNames[tag]);
+    }
+    return false;
+}
+
+const AllocationFrameStats& GetAllocationFrameStats() {
+    return lastFrameStats;
+}
+
+void DrawAllocationOverlay() {
+    if (!showAllocationOverlay) return;
+    const AllocationFrameStats& stats = lastFrameStats;
+    int x = uiPadding, y = screenHeight - 40 - ALLOC_TAG_COUNT * 14;
+    DrawRectangle(x - 5, y - 5, 250, 40 + ALLOC_TAG_COUNT * 14, ColorAlpha(BLACK, 0.7f));
+    DrawText(TextFormat("Allocs %llu  %llu B", (unsigned long long)stats.totalCount, (unsigned long long)stats.totalBytes), x, y, 12, WHITE);
+    DrawText(TextFormat("Live %lld B  peak %lld B", (long long)stats.liveBytes, (long long)stats.peakBytes), x, y + 14, 12, WHITE);
+    for (int tag = 0; tag < ALLOC_TAG_COUNT; tag++) {
+        Color color = stats.counts[tag] > 0 ? YELLOW : GRAY;
+        DrawText(TextFormat("%-8s %6llu %10llu B", allocationTagNames[tag], (unsigned long long)stats.counts[tag], (unsigned long long)stats.bytes[tag]),
+                 x, y + 32 + tag * 14, 12, color);
+    }
+}
+
+#else
+
+static AllocationFrameStats lastFrameStats;
+
+void SetAllocationTag(AllocationTag) {}
+void BeginAllocationFrame() {}
+bool EndAllocationFrame() {
+    if (!allocationAssertEnabled) return true;
+    TraceLog(LOG_ERROR, "ALLOC: --alloc-assert needs a build with TRACK_ALLOCATIONS (make track)");
+    return false;
+}
+const AllocationFrameStats& GetAllocationFrameStats() { return lastFrameStats; }
+void DrawAllocationOverlay() {}
+
+#endif
@@ -0,0 +1,215 @@
+#include "game.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Startup textures. Every slot gets a flat fallback texture up front so the menu can draw on the
+// first frame; worker threads decode the PNGs meanwhile and the main thread uploads each image
+// as it finishes. Fallbacks stay alive until shutdown because towers, enemies and projectiles keep
+// copies of whatever texture was current when they were created.
+//
+// The PNGs normally come from one pack file (.tdpak) next to the executable, built by
+// --pack-assets, which is memory-mapped and decoded in place. Once a pack is mapped it is the only
+// file read: a name missing from it keeps its fallback. Without a pack each PNG is read from the
+// executable's directory instead, so the working directory never matters either way.
+
+struct AssetLoad {
+    string filePath;
+    const uint8_t* packedData; // Inside the mapped pack, or null to read filePath
+    uint32_t packedSize;
+    Texture2D* target;
+    Color fallbackColor;
+    Image image;
+    atomic<bool> decoded;
+    bool uploaded;
+};
+
+static vector<unique_ptr<AssetLoad>> assetLoads;
+static vector<Texture2D> fallbackTextures;
+static vector<thread> assetWorkers;
+static atomic<int> nextAssetToDecode(0);
+static chrono::steady_clock::time_point startupTime = chrono::steady_clock::now();
+static void* assetPackData = nullptr;
+static size_t assetPackSize = 0;
+static int assetsUploaded = 0;
+static bool firstFrameReported = false;
+
+static double GetStartupMilliseconds() {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - startupTime).count();
+}
+
+Texture2D CreateFallbackTexture(Color color) {
+    Image img = GenImageColor(64, 64, color);
+    Texture2D texture = LoadTextureFromImage(img);
+    UnloadImage(img);
+    return texture;
+}
+
+static bool ValidateAssetPack(const uint8_t* data, size_t size) {
+    if (size < sizeof(AssetPackHeader)) return false;
+    const AssetPackHeader* header = (const AssetPackHeader*)data;
+    if (memcmp(header->magic, assetPackMagic, 4) != 0 || header->version != assetPackVersion) return false;
+    if (header->fileSize != size || header->entryCount > (size - sizeof(AssetPackHeader)) / sizeof(AssetPackEntry)) return false;
+    const AssetPackEntry* entries = (const AssetPackEntry*)(data + sizeof(AssetPackHeader));
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        if (memchr(entries[i].name, 0, sizeof(entries[i].name)) == nullptr) return false;
+        if (entries[i].offset > size || entries[i].size > size - entries[i].offset) return false;
+    }
+    return true;
+}
+
+bool PackAssetFiles(const string& outputPath, const vector<string>& inputPaths) {
+    // Offline step run by the makefile; the pack is the header and entry table followed by the files
+    vector<AssetPackEntry> entries(inputPaths.size());
+    vector<string> contents(inputPaths.size());
+    uint32_t offset = (uint32_t)(sizeof(AssetPackHeader) + entries.size() * sizeof(AssetPackEntry));
+    for (size_t i = 0; i < inputPaths.size(); i++) {
+        string name = filesystem::path(inputPaths[i]).filename().string();
+        ifstream input(inputPaths[i], ios::binary);
+        if (!input || name.size() >= sizeof(entries[i].name)) {
+            TraceLog(LOG_WARNING, "ASSETS: Cannot pack %s", inputPaths[i].c_str());
+            return false;
+        }
+        contents[i].assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+        entries[i] = {};
+        memcpy(entries[i].name, name.c_str(), name.size());
+        entries[i].offset = offset;
+        entries[i].size = (uint32_t)contents[i].size();
+        offset += entries[i].size;
+    }
+    AssetPackHeader header = {};
+    memcpy(header.magic, assetPackMagic, 4);
+    header.version = assetPackVersion;
+    header.entryCount = (uint32_t)entries.size();
+    header.fileSize = offset;
+    ofstream output(outputPath, ios::binary);
+    output.write((const char*)&header, sizeof(header));
+    output.write((const char*)entries.data(), entries.size() * sizeof(AssetPackEntry));
+    for (const auto& content : contents) output.write(content.data(), content.size());
+    if (!output) {
+        TraceLog(LOG_WARNING, "ASSETS: Cannot write %s", outputPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool OpenAssetPack() {
+    string path = string(GetApplicationDirectory()) + assetPackFileName;
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        TraceLog(LOG_WARNING, "ASSETS: No %s, reading loose files", path.c_str());
+        return false;
+    }
+    struct stat info;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        TraceLog(LOG_WARNING, "ASSETS: Cannot map %s", path.c_str());
+        return false;
+    }
+    if (!ValidateAssetPack((const uint8_t*)data, (size_t)info.st_size)) {
+        TraceLog(LOG_WARNING, "ASSETS: %s is not a valid asset pack", path.c_str());
+        munmap(data, (size_t)info.st_size);
+        return false;
+    }
+    assetPackData = data;
+    assetPackSize = (size_t)info.st_size;
+    return true;
+}
+
+static const AssetPackEntry* FindPackedAsset(const char* fileName) {
+    if (assetPackData == nullptr) return nullptr;
+    const AssetPackHeader* header = (const AssetPackHeader*)assetPackData;
+    const AssetPackEntry* entries = (const AssetPackEntry*)((const uint8_t*)assetPackData + sizeof(AssetPackHeader));
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        if (strcmp(entries[i].name, fileName) == 0) return &entries[i];
+    }
+    return nullptr;
+}
+
+void QueueTextureLoad(const char* fileName, Texture2D* target, Color fallbackColor) {
+    *target = CreateFallbackTexture(fallbackColor);
+    fallbackTextures.push_back(*target);
+    const AssetPackEntry* packed = FindPackedAsset(fileName);
+    if (assetPackData != nullptr && packed == nullptr) {
+        TraceLog(LOG_WARNING, "ASSETS: %s is not in the pack, keeping its fallback", fileName);
+        return;
+    }
+    auto load = make_unique<AssetLoad>();
+    load->filePath = string(GetApplicationDirectory()) + fileName;
+    load->packedData = packed != nullptr ? (const uint8_t*)assetPackData + packed->offset : nullptr;
+    load->packedSize = packed != nullptr ? packed->size : 0;
+    load->target = target;
+    load->fallbackColor = fallbackColor;
+    load->image = {};
+    load->decoded = false;
+    load->uploaded = false;
+    assetLoads.push_back(move(load));
+}
+
+void StartAssetDecoding() {
+    // Decoding is pure CPU work on separate images; only uploads need the GL context
+    int workerCount = (int)min<size_t>(max(1u, thread::hardware_concurrency()), assetLoads.size());
+    for (int i = 0; i < workerCount; i++) {
+        assetWorkers.emplace_back([]() {
+            for (int index = nextAssetToDecode++; index < (int)assetLoads.size(); index = nextAssetToDecode++) {
+                AssetLoad& load = *assetLoads[index];
+                if (load.packedData != nullptr) load.image = LoadImageFromMemory(".png", load.packedData, (int)load.packedSize);
+                else load.image = LoadImage(load.filePath.c_str());
+                load.decoded.store(true, memory_order_release);
+            }
+        });
+    }
+}
+
+void UploadDecodedAssets() {
+    if (assetsUploaded == (int)assetLoads.size()) return;
+    for (auto& load : assetLoads) {
+        if (load->uploaded || !load->decoded.load(memory_order_acquire)) continue;
+        load->uploaded = true;
+        assetsUploaded++;
+        if (load->image.data == nullptr) continue; // Missing or unreadable file: keep the fallback
+        Texture2D texture = LoadTextureFromImage(load->image);
+        UnloadImage(load->image);
+        load->image = {};
+        if (texture.id != 0) *load->target = texture;
+    }
+    if (assetsUploaded == (int)assetLoads.size()) {
+        TraceLog(LOG_INFO, "STARTUP: %d textures ready after %.1f ms", assetsUploaded, GetStartupMilliseconds());
+    }
+}
+
+void ReportFirstFrame() {
+    if (firstFrameReported) return;
+    firstFrameReported = true;
+    TraceLog(LOG_INFO, "STARTUP: first frame after %.1f ms (%d/%d textures uploaded)", GetStartupMilliseconds(), assetsUploaded, (int)assetLoads.size());
+}
+
+void UnloadAssets() {
+    for (auto& worker : assetWorkers) worker.join();
+    assetWorkers.clear();
+    for (auto& load : assetLoads) {
+        if (load->image.data != nullptr) UnloadImage(load->image);
+        bool isFallback = false;
+        for (const auto& fallback : fallbackTextures) isFallback = isFallback || fallback.id == load->target->id;
+        if (!isFallback) UnloadTexture(*load->target);
+    }
+    for (const auto& fallback : fallbackTextures) UnloadTexture(fallback);
+    assetLoads.clear();
+    fallbackTextures.clear();
+    if (assetPackData != nullptr) munmap(assetPackData, assetPackSize);
+    assetPackData = nullptr;
+    assetPackSize = 0;
+}
+
+bool AreAssetWorkersRunning() {
+    // Workers are only joined at shutdown, so this stays true once decoding has started
+    return !assetWorkers.empty();
+}
@@ -0,0 +1,169 @@
+#include "game.h"
+#include <memory>
+
+// Tile -> towers whose range reaches into the tile. Towers never move, so the lists only
+// change on placement, upgrade and reset. Chunks are allocated the first time a tower
+// covers them, which keeps large mostly-empty maps cheap.
+struct CoverageChunk {
+    vector<int> towers[gridChunkSize * gridChunkSize];
+};
+
+static vector<unique_ptr<CoverageChunk>> coverageChunks;
+static int coverageChunkColumns = 0;
+// Enemies per tile and the towers that currently see at least one of them. A tower is woken when
+// an enemy steps onto a tile it covers and goes dormant when the last one leaves
+static vector<int> enemiesOnTile;
+static vector<int> awakeTowers;
+bool showCoverageHeatmap = false;
+
+static bool TowerReachesTile(const Tower& tower, int col, int row) {
+    float nearestX = clamp(tower.position.x, (float)(col * tileWidth), (float)((col + 1) * tileWidth));
+    float nearestY = clamp(tower.position.y, (float)(row * tileHeight), (float)((row + 1) * tileHeight));
+    return Vector2DistanceSqr(tower.position, { nearestX, nearestY }) < tower.range * tower.range;
+}
+
+template <typename Visit>
+static void ForEachCoveredTile(const Tower& tower, Visit visit) {
+    int minCol = clamp((int)((tower.position.x - tower.range) / tileWidth), 0, gridColumns - 1);
+    int maxCol = clamp((int)((tower.position.x + tower.range) / tileWidth), 0, gridColumns - 1);
+    int minRow = clamp((int)((tower.position.y - tower.range) / tileHeight), 0, gridRows - 1);
+    int maxRow = clamp((int)((tower.position.y + tower.range) / tileHeight), 0, gridRows - 1);
+    for (int row = minRow; row <= maxRow; row++) {
+        for (int col = minCol; col <= maxCol; col++) {
+            if (TowerReachesTile(tower, col, row)) visit(col, row);
+        }
+    }
+}
+
+static vector<int>* GetCoverageList(int col, int row, bool create) {
+    unique_ptr<CoverageChunk>& chunk = coverageChunks[(row / gridChunkSize) * coverageChunkColumns + col / gridChunkSize];
+    if (!chunk) {
+        if (!create) return nullptr;
+        chunk = make_unique<CoverageChunk>();
+    }
+    return &chunk->towers[(row % gridChunkSize) * gridChunkSize + col % gridChunkSize];
+}
+
+static void SetCoveredEnemyCount(int towerIndex, int count) {
+    Tower& tower = towers[towerIndex];
+    bool wasAwake = tower.coveredEnemyCount > 0;
+    tower.coveredEnemyCount = count;
+    if (count > 0 && !wasAwake) {
+        tower.awakeSlot = (int)awakeTowers.size();
+        awakeTowers.push_back(towerIndex);
+    } else if (count == 0 && wasAwake) {
+        int movedTower = awakeTowers.back();
+        awakeTowers[tower.awakeSlot] = movedTower;
+        towers[movedTower].awakeSlot = tower.awakeSlot;
+        awakeTowers.pop_back();
+        tower.awakeSlot = -1;
+    }
+}
+
+static void ChangeTileOccupancy(int cell, int delta) {
+    enemiesOnTile[cell] += delta;
+    const vector<int>* covering = GetCoverageList(cell % gridColumns, cell / gridColumns, false);
+    if (covering == nullptr) return;
+    for (int towerIndex : *covering) SetCoveredEnemyCount(towerIndex, towers[towerIndex].coveredEnemyCount + delta);
+}
+
+void ResetTowerCoverage() {
+    coverageChunkColumns = (gridColumns + gridChunkSize - 1) / gridChunkSize;
+    coverageChunks.clear();
+    coverageChunks.resize((size_t)coverageChunkColumns * ((gridRows + gridChunkSize - 1) / gridChunkSize));
+    enemiesOnTile.assign((size_t)gridColumns * gridRows, 0);
+    awakeTowers.clear();
+    for (auto& tower : towers) {
+        tower.coveredEnemyCount = 0;
+        tower.awakeSlot = -1;
+    }
+    for (auto& enemy : enemies) enemy.occupiedCell = -1;
+    for (int i = 0; i < (int)towers.size(); i++) AddTowerCoverage(i);
+    UpdateEnemyTileOccupancy();
+}
+
+void AddTowerCoverage(int towerIndex) {
+    int coveredEnemies = 0;
+    ForEachCoveredTile(towers[towerIndex], [towerIndex, &coveredEnemies](int col, int row) {
+        GetCoverageList(col, row, true)->push_back(towerIndex);
+        coveredEnemies += enemiesOnTile[row * gridColumns + col];
+    });
+    SetCoveredEnemyCount(towerIndex, coveredEnemies);
+}
+
+void RemoveTowerCoverage(int towerIndex) {
+    // Must run before the tower's range changes so the same tiles are visited
+    ForEachCoveredTile(towers[towerIndex], [towerIndex](int col, int row) {
+        vector<int>* list = GetCoverageList(col, row, false);
+        if (list != nullptr) list->erase(remove(list->begin(), list->end(), towerIndex), list->end());
+    });
+    SetCoveredEnemyCount(towerIndex, 0);
+}
+
+void UpdateEnemyTileOccupancy() {
+    TraceScope trace("UpdateEnemyTileOccupancy");
+    // Only enemies that changed tile (or spawned, or died) touch the towers covering them
+    for (auto& enemy : enemies) {
+        int cell = enemy.active ? GetEnemyCellIndex(enemy.position) : -1;
+        if (cell == enemy.occupiedCell) continue;
+        if (enemy.occupiedCell >= 0) ChangeTileOccupancy(enemy.occupiedCell, -1);
+        if (cell >= 0) ChangeTileOccupancy(cell, 1);
+        enemy.occupiedCell = cell;
+    }
+}
+
+void ReleaseEnemyTile(Enemy& enemy) {
+    if (enemy.occupiedCell < 0) return;
+    ChangeTileOccupancy(enemy.occupiedCell, -1);
+    enemy.occupiedCell = -1;
+}
+
+const vector<int>& GetAwakeTowers() {
+    return awakeTowers;
+}
+
+const vector<int>* GetTowersCoveringTile(Vector2Int gridCoords) {
+    if (!IsInsideGrid(gridCoords.x, gridCoords.y) || coverageChunks.empty()) return nullptr;
+    const vector<int>* list = GetCoverageList(gridCoords.x, gridCoords.y, false);
+    return list != nullptr && !list->empty() ? list : nullptr;
+}
+
+void HandleCoverageHeatmapToggle() {
+    if (IsKeyPressed(KEY_H)) showCoverageHeatmap = !showCoverageHeatmap;
+}
+
+void DrawCoverageHeatmap(const RenderSnapshot& snapshot) {
+    TraceScope trace("DrawCoverageHeatmap");
+    if (!showCoverageHeatmap) return;
+    int minCol, maxCol, minRow, maxRow;
+    GetVisibleTileRange(minCol, maxCol, minRow, maxRow);
+    // Scale against the strongest visible tile so the overlay stays readable as the board grows
+    float maxDps = 0.0f;
+    static vector<float> tileDps;
+    tileDps.assign((size_t)(maxCol - minCol + 1) * (maxRow - minRow + 1), 0.0f);
+    for (int row = minRow; row <= maxRow; row++) {
+        for (int col = minCol; col <= maxCol; col++) {
+            const vector<int>* covering = GetTowersCoveringTile({ col, row });
+            if (covering == nullptr) continue;
+            float dps = 0.0f;
+            for (int towerIndex : *covering) {
+                // Towers placed since the snapshot show up next frame
+                if (towerIndex < (int)snapshot.towers.size()) dps += snapshot.towers[towerIndex].dps;
+            }
+            tileDps[(row - minRow) * (maxCol - minCol + 1) + (col - minCol)] = dps;
+            maxDps = max(maxDps, dps);
+        }
+    }
+    if (maxDps <= 0.0f) return;
+    for (int row = minRow; row <= maxRow; row++) {
+        for (int col = minCol; col <= maxCol; col++) {
+            float dps = tileDps[(row - minRow) * (maxCol - minCol + 1) + (col - minCol)];
+            if (dps <= 0.0f) continue;
+            float heat = dps / maxDps;
+            // Blue for light coverage through yellow to red where the most damage lands
+            Color color = { (unsigned char)(255 * min(1.0f, heat * 2.0f)), (unsigned char)(255 * min(1.0f, 2.0f - heat * 2.0f) * min(1.0f, heat * 2.0f)),
+                            (unsigned char)(255 * max(0.0f, 1.0f - heat * 2.0f)), 255 };
+            DrawRectangle(col * tileWidth, row * tileHeight, tileWidth, tileHeight, ColorAlpha(color, 0.35f));
+        }
+    }
+}
@@ -0,0 +1,154 @@
+#include "game.h"
+#include <cstring>
+
+// Archetype entity storage. Entities with the same set of components share an archetype, which
+// keeps one tightly packed column per component plus the owning handle of each row, so a system
+// walks plain arrays. Adding or removing a component moves the entity's row to the archetype for
+// its new mask; removal swaps the last row into the hole. Components are plain data and are
+// copied with memcpy. Columns and archetypes keep their capacity, so steady-state churn does not
+// allocate. Only the simulation touches this storage (the main thread only while the sim is idle).
+
+struct EntityRecord {
+    uint32_t generation; // Bumped when the slot is freed so stale handles stop matching
+    int archetype;       // -1 while the slot is free
+    uint32_t row;
+};
+
+static const size_t componentSizes[COMPONENT_TYPE_COUNT] = {
+    sizeof(Vector2), sizeof(LifetimeComponent), sizeof(FadingCircleComponent), sizeof(BeamComponent),
+    sizeof(int), sizeof(SlowedComponent), sizeof(BurningComponent), sizeof(ProjectileComponent), sizeof(SplashComponent),
+};
+
+static vector<unique_ptr<Archetype>> archetypes;
+static vector<EntityRecord> entityRecords;
+static vector<uint32_t> freeEntitySlots;
+
+static int GetArchetype(ComponentMask mask) {
+    for (size_t i = 0; i < archetypes.size(); i++) {
+        if (archetypes[i]->mask == mask) return (int)i;
+    }
+    auto archetype = make_unique<Archetype>();
+    archetype->mask = mask;
+    archetypes.push_back(move(archetype));
+    return (int)archetypes.size() - 1;
+}
+
+static uint32_t AppendRow(Archetype& archetype, EntityHandle entity) {
+    // New components start zeroed
+    uint32_t row = (uint32_t)archetype.entities.size();
+    archetype.entities.push_back(entity);
+    for (int type = 0; type < COMPONENT_TYPE_COUNT; type++) {
+        if (archetype.mask & ComponentBit((ComponentType)type)) archetype.columns[type].resize((row + 1) * componentSizes[type]);
+    }
+    return row;
+}
+
+static void RemoveRow(Archetype& archetype, uint32_t row) {
+    uint32_t last = (uint32_t)archetype.entities.size() - 1;
+    for (int type = 0; type < COMPONENT_TYPE_COUNT; type++) {
+        if (!(archetype.mask & ComponentBit((ComponentType)type))) continue;
+        vector<uint8_t>& column = archetype.columns[type];
+        size_t size = componentSizes[type];
+        if (row != last) memcpy(&column[row * size], &column[last * size], size);
+        column.resize(last * size);
+    }
+    if (row != last) {
+        archetype.entities[row] = archetype.entities[last];
+        entityRecords[archetype.entities[row].index].row = row;
+    }
+    archetype.entities.pop_back();
+}
+
+static void ChangeEntityArchetype(EntityHandle entity, ComponentMask mask) {
+    EntityRecord& record = entityRecords[entity.index];
+    int targetIndex = GetArchetype(mask);
+    Archetype& source = *archetypes[record.archetype];
+    Archetype& target = *archetypes[targetIndex];
+    uint32_t row = AppendRow(target, entity);
+    ComponentMask shared = source.mask & mask;
+    for (int type = 0; type < COMPONENT_TYPE_COUNT; type++) {
+        if (!(shared & ComponentBit((ComponentType)type))) continue;
+        size_t size = componentSizes[type];
+        memcpy(&target.columns[type][row * size], &source.columns[type][record.row * size], size);
+    }
+    RemoveRow(source, record.row);
+    record.archetype = targetIndex;
+    record.row = row;
+}
+
+EntityHandle CreateEntity(ComponentMask mask) {
+    uint32_t index;
+    if (!freeEntitySlots.empty()) {
+        index = freeEntitySlots.back();
+        freeEntitySlots.pop_back();
+    } else {
+        index = (uint32_t)entityRecords.size();
+        entityRecords.push_back({ 1, -1, 0 }); // Generation 0 is never live, so a zeroed handle is null
+    }
+    EntityRecord& record = entityRecords[index];
+    EntityHandle entity = { index, record.generation };
+    record.archetype = GetArchetype(mask);
+    record.row = AppendRow(*archetypes[record.archetype], entity);
+    return entity;
+}
+
+bool IsEntityAlive(EntityHandle entity) {
+    if (entity.index >= entityRecords.size()) return false;
+    const EntityRecord& record = entityRecords[entity.index];
+    return record.generation == entity.generation && record.archetype >= 0;
+}
+
+void DestroyEntity(EntityHandle entity) {
+    if (!IsEntityAlive(entity)) return;
+    EntityRecord& record = entityRecords[entity.index];
+    RemoveRow(*archetypes[record.archetype], record.row);
+    record.archetype = -1;
+    record.generation++;
+    freeEntitySlots.push_back(entity.index);
+}
+
+ComponentMask GetEntityMask(EntityHandle entity) {
+    if (!IsEntityAlive(entity)) return 0;
+    return archetypes[entityRecords[entity.index].archetype]->mask;
+}
+
+bool HasComponent(EntityHandle entity, ComponentType type) {
+    return (GetEntityMask(entity) & ComponentBit(type)) != 0;
+}
+
+void AddComponent(EntityHandle entity, ComponentType type) {
+    if (!IsEntityAlive(entity) || HasComponent(entity, type)) return;
+    ChangeEntityArchetype(entity, GetEntityMask(entity) | ComponentBit(type));
+}
+
+void RemoveComponent(EntityHandle entity, ComponentType type) {
+    if (!HasComponent(entity, type)) return;
+    ChangeEntityArchetype(entity, GetEntityMask(entity) & ~ComponentBit(type));
+}
+
+void* GetComponentData(EntityHandle entity, ComponentType type) {
+    if (!HasComponent(entity, type)) return nullptr;
+    const EntityRecord& record = entityRecords[entity.index];
+    return &archetypes[record.archetype]->columns[type][record.row * componentSizes[type]];
+}
+
+void QueryArchetypes(ComponentMask required, vector<Archetype*>& outArchetypes) {
+    // Rows may not be added or removed while iterating the result; systems defer those changes
+    outArchetypes.clear();
+    for (auto& archetype : archetypes) {
+        if ((archetype->mask & required) == required && !archetype->entities.empty()) outArchetypes.push_back(archetype.get());
+    }
+}
+
+void ClearEntities() {
+    for (auto& archetype : archetypes) {
+        archetype->entities.clear();
+        for (auto& column : archetype->columns) column.clear();
+    }
+    freeEntitySlots.clear();
+    for (uint32_t index = 0; index < entityRecords.size(); index++) {
+        if (entityRecords[index].archetype >= 0) entityRecords[index].generation++;
+        entityRecords[index].archetype = -1;
+        freeEntitySlots.push_back(index);
+    }
+}
@@ -1,19 +1,17 @@
 #include "game.h"
+#include <unordered_map>
 
 Enemy CreateEnemy(EnemyType type, Vector2 startPosition) {
     Enemy newEnemy;
+    newEnemy.id = nextEnemyId++;
+    newEnemy.occupiedCell = -1;
     newEnemy.position = startPosition;
     newEnemy.currentWaypoint = 0;
     newEnemy.active = true;
     newEnemy.type = type;
     newEnemy.texture = { 0 };
-    newEnemy.slowTimer = 0.0f;
-    newEnemy.isSlowed = false;
-    newEnemy.hasDotEffect = false;
-    newEnemy.dotTimer = 0.0f;
-    newEnemy.dotTickTimer = 0.0f;
-    newEnemy.dotDamage = 0;
     newEnemy.pathCheckTimer = 0.0f; // Initialize individual path check timer
+    newEnemy.pathRequested = false;
     switch (type) {
         case BASIC_ENEMY:
             newEnemy.speed = 60.0f;
@@ -52,21 +50,74 @@ Enemy CreateEnemy(EnemyType type, Vector2 startPosition) {
     }
     newEnemy.originalSpeed = newEnemy.speed;
     
-    // Calculate initial path when enemy is created
-    Vector2Int startGrid = GetGridCoords(newEnemy.position);
-    Vector2Int endGrid = GetGridCoords(waypoints[waypoints.size()-1]);
-    newEnemy.waypointsPath = FindPathBFS(startGrid, endGrid);
-    newEnemy.pathIndex = 0;
+    // Calculate initial path when enemy is created; enemies spawned at the same point on an
+    // unchanged grid share the route built for the first of them
+    static shared_ptr<const PathRoute> spawnRoute;
+    static vector<Vector2Int> spawnRoutePath;
+    static Vector2 spawnRouteStart;
+    static int spawnRouteVersion = -1;
+    if (spawnRoute && spawnRouteVersion == gridVersion && spawnRouteStart.x == startPosition.x && spawnRouteStart.y == startPosition.y) {
+        newEnemy.waypointsPath = spawnRoutePath;
+        newEnemy.route = spawnRoute;
+    } else if (const vector<Vector2Int>* path = GetFinishedPath(GetGridCoords(newEnemy.position))) {
+        SetEnemyPath(newEnemy, *path);
+        spawnRoute = newEnemy.route;
+        spawnRoutePath = newEnemy.waypointsPath;
+        spawnRouteStart = startPosition;
+        spawnRouteVersion = gridVersion;
+    } else {
+        // Follow the static route until the path service answers
+        SetEnemyPath(newEnemy, {});
+        RequestEnemyPath(newEnemy);
+    }
     
     return newEnemy;
 }
 
+shared_ptr<const PathRoute> BuildPathRoute(Vector2 start, const vector<Vector2>& points) {
+    auto route = make_shared<PathRoute>();
+    route->points.reserve(points.size() + 1);
+    route->points.push_back(start);
+    route->points.insert(route->points.end(), points.begin(), points.end());
+    route->directions.reserve(points.size());
+    route->segmentStarts.reserve(points.size() + 1);
+    float total = 0.0f;
+    for (size_t i = 0; i + 1 < route->points.size(); i++) {
+        Vector2 delta = Vector2Subtract(route->points[i + 1], route->points[i]);
+        float length = Vector2Length(delta);
+        route->directions.push_back(length > 0.0f ? Vector2Scale(delta, 1.0f / length) : Vector2{ 0.0f, 0.0f });
+        route->segmentStarts.push_back(total);
+        total += length;
+    }
+    route->segmentStarts.push_back(total);
+    return route;
+}
+
+void SetEnemyPath(Enemy& enemy, const vector<Vector2Int>& path) {
+    // The route starts where the enemy stands, so segment i ends at the center of path[i]
+    enemy.waypointsPath = path;
+    enemy.pathIndex = 0;
+    vector<Vector2> centers;
+    if (!path.empty()) {
+        centers.reserve(path.size());
+        for (const auto& tile : path) centers.push_back(GetTileCenter(tile));
+    } else { // fall back to default static waypoints; segment i then ends at waypoints[i]
+        centers = waypoints;
+        enemy.currentWaypoint = 0;
+    }
+    // Separation keeps applying on top of the new route, so start it from the undisplaced position
+    enemy.route = BuildPathRoute(Vector2Subtract(enemy.position, enemy.separationOffset), centers);
+    enemy.routeDistance = 0.0f;
+    enemy.routeSegment = 0;
+}
+
 void UpdateEnemies() {
+    TraceScope trace("UpdateEnemies");
     for (auto &enemy : enemies) {
         if (!enemy.active) continue;
         
         // Update individual path check timer
-        enemy.pathCheckTimer -= GetFrameTime();
+        enemy.pathCheckTimer -= simTickDuration;
         
         // Check if we need to recalculate path
         bool needsRecalculation = false;
@@ -81,159 +132,432 @@ void UpdateEnemies() {
             } 
             else if (enemy.pathIndex < enemy.waypointsPath.size()) {
                 // Check if the next waypoint is blocked
-                if (!grid[enemy.waypointsPath[enemy.pathIndex].y][enemy.waypointsPath[enemy.pathIndex].x]) {
+                if (!IsTileWalkable(enemy.waypointsPath[enemy.pathIndex].x, enemy.waypointsPath[enemy.pathIndex].y)) {
                     needsRecalculation = true;
                 }
             }
             
-            // Recalculate path if needed
-            if (needsRecalculation) {
-                Vector2Int currentGridPos = GetGridCoords(enemy.position);
-                Vector2Int endGridPos = GetGridCoords(waypoints[waypoints.size() - 1]);
-                
-                // Calculate a new path that avoids towers using BFS
-                vector<Vector2Int> newPath = FindPathBFS(currentGridPos, endGridPos);
-                
-                // Only update the path if we found a valid one
-                if (!newPath.empty()) {
-                    enemy.waypointsPath = newPath;
-                    enemy.pathIndex = 0;
-                }
-                // If no valid path found, keep the current path and try again later
-            }
+            // Ask for a new path; the enemy keeps its current one until the answer arrives
+            if (needsRecalculation) RequestEnemyPath(enemy);
+        }
+        // Paths come in stretches; ask for the next one before the enemy reaches the end of this one
+        if (!enemy.waypointsPath.empty() && enemy.waypointsPath.size() - enemy.pathIndex <= (size_t)pathRefineMargin &&
+            !IsGoalTile(enemy.waypointsPath.back())) {
+            RequestEnemyPath(enemy);
         }
 
-        // Follow the path
-        if (!enemy.waypointsPath.empty()) {
-            if (enemy.pathIndex < enemy.waypointsPath.size()) {
-                Vector2 target = GetTileCenter(enemy.waypointsPath[enemy.pathIndex]);
-                Vector2 direction = Vector2Subtract(target, enemy.position);
-                float distance = Vector2Length(direction);
-                if (distance < 5.0f) {
-                    enemy.pathIndex++;
-                } else {
-                    Vector2 normalizedDir = Vector2Normalize(direction);
-                    enemy.position = Vector2Add(enemy.position, Vector2Scale(normalizedDir, enemy.speed * GetFrameTime()));
-                }
+        // Follow the route: advance the travelled distance, step past finished segments and place
+        // the enemy on the current one. Leftover movement carries into the next segment exactly
+        if (enemy.route) {
+            const PathRoute& route = *enemy.route;
+            int segmentCount = (int)route.directions.size();
+            enemy.routeDistance = min(enemy.routeDistance + enemy.speed * simTickDuration, route.segmentStarts[segmentCount]);
+            while (enemy.routeSegment < segmentCount && enemy.routeDistance >= route.segmentStarts[enemy.routeSegment + 1]) enemy.routeSegment++;
+            if (enemy.routeSegment < segmentCount) {
+                float along = enemy.routeDistance - route.segmentStarts[enemy.routeSegment];
+                enemy.position = Vector2Add(route.points[enemy.routeSegment], Vector2Scale(route.directions[enemy.routeSegment], along));
             } else {
-                enemy.active = false;
-                enemiesReachedEnd++;
-                if (enemiesReachedEnd >= maxEnemiesReachedEnd) currentState = GAME_OVER;
+                enemy.position = route.points.back();
             }
-        } else { // fall back to default static waypoints
-            if (enemy.currentWaypoint < waypoints.size()) {
-                Vector2 target = waypoints[enemy.currentWaypoint];
-                Vector2 direction = Vector2Subtract(target, enemy.position);
-                float distance = Vector2Length(direction);
-                if (distance < 5.0f) {
-                    enemy.currentWaypoint++;
-                } else {
-                    Vector2 normalizedDir = Vector2Normalize(direction);
-                    enemy.position = Vector2Add(enemy.position, Vector2Scale(normalizedDir, enemy.speed * GetFrameTime()));
+            enemy.position = Vector2Add(enemy.position, enemy.separationOffset);
+            // Enemies past the last tile are escaped by ProcessEscapedEnemies via the progress index
+            if (!enemy.waypointsPath.empty()) enemy.pathIndex = enemy.routeSegment;
+            else enemy.currentWaypoint = enemy.routeSegment;
+        }
+    }
+    UpdateEnemyStatuses();
+    if (enemySeparationEnabled) ApplyEnemySeparation();
+}
+
+// Status effects (slow, burning) are components on one status entity per affected enemy, so an
+// enemy with none costs nothing and a new status is a new component plus a branch below
+static EntityHandle GetEnemyStatusEntity(Enemy& enemy) {
+    if (!IsEntityAlive(enemy.statusEntity)) {
+        enemy.statusEntity = CreateEntity(ComponentBit(COMPONENT_STATUS_TARGET));
+        *GetComponent<int>(enemy.statusEntity, COMPONENT_STATUS_TARGET) = enemy.id;
+    }
+    return enemy.statusEntity;
+}
+
+void ApplyEnemySlow(Enemy& enemy, float duration) {
+    EntityHandle entity = GetEnemyStatusEntity(enemy);
+    AddComponent(entity, COMPONENT_SLOWED);
+    GetComponent<SlowedComponent>(entity, COMPONENT_SLOWED)->timer = duration;
+    enemy.speed = enemy.originalSpeed * 0.5f;
+}
+
+void ApplyEnemyBurning(Enemy& enemy, float duration, int damage, int sourceTower) {
+    EntityHandle entity = GetEnemyStatusEntity(enemy);
+    AddComponent(entity, COMPONENT_BURNING);
+    BurningComponent* burning = GetComponent<BurningComponent>(entity, COMPONENT_BURNING);
+    burning->timer = duration;
+    burning->tickTimer = 0.5f;
+    burning->damage = damage;
+    burning->sourceTower = sourceTower;
+}
+
+void UpdateEnemyStatuses() {
+    TraceScope trace("UpdateEnemyStatuses");
+    static vector<Archetype*> statusArchetypes;
+    static vector<pair<EntityHandle, ComponentType>> expiredStatuses;
+    expiredStatuses.clear();
+    QueryArchetypes(ComponentBit(COMPONENT_STATUS_TARGET), statusArchetypes);
+    for (Archetype* archetype : statusArchetypes) {
+        const int* targets = GetComponentColumn<int>(*archetype, COMPONENT_STATUS_TARGET);
+        SlowedComponent* slows = GetComponentColumn<SlowedComponent>(*archetype, COMPONENT_SLOWED);
+        BurningComponent* burns = GetComponentColumn<BurningComponent>(*archetype, COMPONENT_BURNING);
+        for (size_t row = 0; row < archetype->entities.size(); row++) {
+            EntityHandle entity = archetype->entities[row];
+            Enemy* enemy = FindEnemyById(targets[row]);
+            if (enemy == nullptr || !enemy->active) {
+                // Target died or escaped; drop the whole status entity
+                expiredStatuses.push_back({ entity, COMPONENT_STATUS_TARGET });
+                continue;
+            }
+            if (slows != nullptr) {
+                slows[row].timer -= simTickDuration;
+                if (slows[row].timer <= 0.0f) {
+                    enemy->speed = enemy->originalSpeed;
+                    expiredStatuses.push_back({ entity, COMPONENT_SLOWED });
                 }
-            } else {
-                enemy.active = false;
-                enemiesReachedEnd++;
-                if (enemiesReachedEnd >= maxEnemiesReachedEnd) currentState = GAME_OVER;
             }
-        }
-        
-        // Handle enemy status effect updates (slow, DoT, etc.)
-        if (enemy.isSlowed) {
-            enemy.slowTimer -= GetFrameTime();
-            if (enemy.slowTimer <= 0.0f) {
-                enemy.isSlowed = false;
-                enemy.speed = enemy.originalSpeed;
+            if (burns != nullptr) {
+                BurningComponent& burning = burns[row];
+                burning.timer -= simTickDuration;
+                burning.tickTimer -= simTickDuration;
+                if (burning.tickTimer <= 0.0f) {
+                    enemy->hp -= burning.damage;
+                    burning.tickTimer = 0.5f;
+                    RecordTowerDamage(burning.sourceTower, DAMAGE_BURN, burning.damage, enemy->hp);
+                    if (enemy->hp <= 0) {
+                        enemy->active = false;
+                        playerMoney += 10;
+                        defeatedEnemies++;
+                    }
+                }
+                if (burning.timer <= 0.0f) expiredStatuses.push_back({ entity, COMPONENT_BURNING });
             }
         }
-        
-        if (enemy.hasDotEffect) {
-            enemy.dotTimer -= GetFrameTime();
-            enemy.dotTickTimer -= GetFrameTime();
-            if (enemy.dotTickTimer <= 0.0f) {
-                enemy.hp -= enemy.dotDamage;
-                enemy.dotTickTimer = 0.5f;
-                if (enemy.hp <= 0) {
-                    enemy.active = false;
-                    playerMoney += 10;
-                    defeatedEnemies++;
+    }
+    // Archetype changes wait until iteration is done; an entity left with only its target goes away
+    for (const auto& expired : expiredStatuses) {
+        if (expired.second != COMPONENT_STATUS_TARGET) RemoveComponent(expired.first, expired.second);
+        if (expired.second == COMPONENT_STATUS_TARGET || GetEntityMask(expired.first) == ComponentBit(COMPONENT_STATUS_TARGET)) DestroyEntity(expired.first);
+    }
+}
+
+bool enemySeparationEnabled = true;
+
+// Per-tick binning of enemy positions into square cells one separation radius wide, sorted by
+// cell so each row of a 3x3 neighbourhood is one contiguous run
+struct SeparationEntry {
+    int cell;
+    int enemyIndex;
+    Vector2 position; // Copied so neighbour scans stay inside the bin array
+};
+
+static vector<SeparationEntry> separationBins;
+static vector<Vector2> separationPush;
+
+void ApplyEnemySeparation() {
+    int binColumns = (int)ceilf(gridColumns * tileWidth / separationRadius) + 1;
+    int binRows = (int)ceilf(gridRows * tileHeight / separationRadius) + 1;
+    auto getBin = [binColumns, binRows](Vector2 position, int& col, int& row) {
+        col = clamp((int)(position.x / separationRadius), 0, binColumns - 1);
+        row = clamp((int)(position.y / separationRadius), 0, binRows - 1);
+    };
+    separationBins.clear();
+    for (int i = 0; i < (int)enemies.size(); i++) {
+        if (!enemies[i].active) continue;
+        int col, row;
+        getBin(enemies[i].position, col, row);
+        separationBins.push_back({ row * binColumns + col, i, enemies[i].position });
+    }
+    sort(separationBins.begin(), separationBins.end(), [](const SeparationEntry& a, const SeparationEntry& b) {
+        return a.cell < b.cell || (a.cell == b.cell && a.enemyIndex < b.enemyIndex);
+    });
+
+    // Gather every push from the same snapshot of positions before moving anyone. Entries are
+    // visited in cell order, so the start of each neighbouring row only ever moves forward
+    separationPush.assign(enemies.size(), { 0.0f, 0.0f });
+    size_t rowCursors[3] = { 0, 0, 0 };
+    for (const auto& entry : separationBins) {
+        int col, row, neighbors = 0;
+        getBin(entry.position, col, row);
+        Vector2 push = { 0.0f, 0.0f };
+        for (int rowOffset = -1; rowOffset <= 1 && neighbors < maxSeparationNeighbors; rowOffset++) {
+            int r = row + rowOffset;
+            if (r < 0 || r >= binRows) continue;
+            int firstCell = r * binColumns + max(col - 1, 0);
+            int lastCell = r * binColumns + min(col + 1, binColumns - 1);
+            size_t& cursor = rowCursors[rowOffset + 1];
+            while (cursor < separationBins.size() && separationBins[cursor].cell < firstCell) cursor++;
+            for (size_t k = cursor; k < separationBins.size() && separationBins[k].cell <= lastCell && neighbors < maxSeparationNeighbors; k++) {
+                const SeparationEntry& other = separationBins[k];
+                if (other.enemyIndex == entry.enemyIndex) continue;
+                Vector2 away = Vector2Subtract(entry.position, other.position);
+                float distanceSq = Vector2LengthSqr(away);
+                if (distanceSq >= separationRadius * separationRadius) continue;
+                neighbors++;
+                float distance = sqrtf(distanceSq);
+                if (distance < 0.001f) {
+                    // Exactly stacked (same spawn, same route): split the pair by id, which follows index order
+                    float side = entry.enemyIndex < other.enemyIndex ? -1.0f : 1.0f;
+                    away = { side, -side };
+                    distance = 1.0f;
                 }
+                push = Vector2Add(push, Vector2Scale(away, (1.0f - distance / separationRadius) / distance));
             }
-            if (enemy.dotTimer <= 0.0f) enemy.hasDotEffect = false;
         }
+        separationPush[entry.enemyIndex] = push;
+    }
+
+    for (const auto& entry : separationBins) {
+        Enemy& enemy = enemies[entry.enemyIndex];
+        Vector2 push = separationPush[entry.enemyIndex];
+        if (push.x == 0.0f && push.y == 0.0f) continue;
+        // Only steer across the lane; pushing along the route would just change speed
+        if (enemy.route && enemy.routeSegment < (int)enemy.route->directions.size()) {
+            Vector2 direction = enemy.route->directions[enemy.routeSegment];
+            Vector2 across = { -direction.y, direction.x };
+            if (across.x != 0.0f || across.y != 0.0f) push = Vector2Scale(across, Vector2DotProduct(push, across));
+        }
+        Vector2 offset = Vector2Add(enemy.separationOffset, Vector2Scale(push, separationStrength * simTickDuration));
+        float offsetLength = Vector2Length(offset);
+        if (offsetLength > maxSeparationOffset) offset = Vector2Scale(offset, maxSeparationOffset / offsetLength);
+        enemy.position = Vector2Add(enemy.position, Vector2Subtract(offset, enemy.separationOffset));
+        enemy.separationOffset = offset;
     }
 }
 
-void DrawEnemies() {
-    // First draw all enemy paths for better layering
-    for (const auto& enemy : enemies) {
-        if (!enemy.active || enemy.waypointsPath.empty()) continue;
-        
-        // Draw the dynamic path the enemy is following
-        for (size_t i = enemy.pathIndex; i < enemy.waypointsPath.size() - 1; ++i) {
-            Vector2 start = GetTileCenter(enemy.waypointsPath[i]);
-            Vector2 end = GetTileCenter(enemy.waypointsPath[i + 1]);
-            
-            // Use enemy color with reduced alpha for the path
-            Color pathColor = ColorAlpha(enemy.color, 0.3f);
-            DrawLineEx(start, end, 2.0f, pathColor);
-            
-            // Draw small circles at path nodes
-            DrawCircleV(start, 3.0f, pathColor);
-            if (i == enemy.waypointsPath.size() - 2) {
-                DrawCircleV(end, 3.0f, pathColor);
-            }
+static float GetDistanceToSegmentEnd(const Enemy& enemy, Vector2 segmentEnd) {
+    // Enemies on a route lie on a straight segment, so what is left of it is already known
+    if (enemy.route && enemy.routeSegment + 1 < (int)enemy.route->segmentStarts.size()) {
+        return enemy.route->segmentStarts[enemy.routeSegment + 1] - enemy.routeDistance;
+    }
+    return Vector2Distance(enemy.position, segmentEnd);
+}
+
+float GetEnemyRemainingDistance(const Enemy& enemy) {
+    // Distance to goal measured through the goal distance field from the tile the enemy is heading to
+    if (!enemy.waypointsPath.empty()) {
+        if (enemy.pathIndex >= enemy.waypointsPath.size()) {
+            // A partial path waits at its last tile for the next stretch; only the goal tile is the end.
+            // A tail cut off from the goal since the stretch was planned ranks behind every routed enemy.
+            int tilesLeft = GetGoalDistance(enemy.waypointsPath.back());
+            if (tilesLeft < 0) return (float)(gridColumns * gridRows) * tileWidth;
+            return (float)tilesLeft * tileWidth;
         }
+        Vector2Int nextTile = enemy.waypointsPath[enemy.pathIndex];
+        int tilesLeft = GetGoalDistance(nextTile);
+        if (tilesLeft < 0) tilesLeft = (int)(enemy.waypointsPath.size() - enemy.pathIndex - 1);
+        return (float)tilesLeft * tileWidth + GetDistanceToSegmentEnd(enemy, GetTileCenter(nextTile));
     }
+    if (enemy.currentWaypoint >= waypoints.size()) return 0.0f;
+    float waypointsLeft = (float)(waypoints.size() - enemy.currentWaypoint - 1);
+    return waypointsLeft * tileWidth + GetDistanceToSegmentEnd(enemy, waypoints[enemy.currentWaypoint]);
+}
 
-    // Then draw all enemies over the paths
-    for (const auto& enemy : enemies) {
-        if (!enemy.active) continue;
-        if (enemy.texture.id > 0) {
-            Rectangle sourceRec = { 0.0f, 0.0f, (float)enemy.texture.width, (float)enemy.texture.height };
-            Rectangle destRec = { enemy.position.x - tileWidth / 2, enemy.position.y - tileHeight / 2, (float)tileWidth, (float)tileHeight };
-            DrawTexturePro(enemy.texture, sourceRec, destRec, { 0, 0 }, 0.0f, WHITE);
+// Swarm level of detail. Past lodEnemyThreshold visible enemies, or past lodMinEnemies when the
+// last frame ran over frameTimeTarget, enemies sharing a tile are drawn as one sprite with a count
+// badge and one HP bar for the group, and overlapping paths are drawn once. Details smaller than a
+// couple of pixels at the current zoom are skipped either way.
+bool enemyLodActive = false;
+
+struct SwarmEntry {
+    int cell;
+    int enemyIndex;
+};
+
+static vector<SwarmEntry> swarmEntries;
+
+static void UpdateEnemyLod(int visibleCount) {
+    // Some slack on the way back so the mode does not flip every other frame
+    bool overBudget = lastFrameWorkTime > frameTimeTarget;
+    if (!enemyLodActive) {
+        enemyLodActive = visibleCount > lodEnemyThreshold || (visibleCount > lodMinEnemies && overBudget);
+    } else {
+        bool relaxed = lastFrameWorkTime < frameTimeTarget * 0.5f;
+        enemyLodActive = visibleCount > lodEnemyThreshold * 3 / 4 || (visibleCount > lodMinEnemies && !relaxed);
+    }
+}
+
+static void DrawRoutePath(const PathRoute& route, int routeSegment, Color color) {
+    // Route point i + 1 is the center of path tile i
+    const vector<Vector2>& points = route.points;
+    Color pathColor = ColorAlpha(color, 0.3f);
+    for (size_t i = routeSegment + 1; i + 1 < points.size(); ++i) {
+        DrawLineEx(points[i], points[i + 1], 2.0f, pathColor);
+        DrawCircleV(points[i], 3.0f, pathColor);
+        if (i == points.size() - 2) DrawCircleV(points[i + 1], 3.0f, pathColor);
+    }
+}
+
+static void DrawEnemySprite(const EnemySprite& enemy, Vector2 position) {
+    if (enemy.texture.id > 0) {
+        Rectangle sourceRec = { 0.0f, 0.0f, (float)enemy.texture.width, (float)enemy.texture.height };
+        Rectangle destRec = { position.x - tileWidth / 2, position.y - tileHeight / 2, (float)tileWidth, (float)tileHeight };
+        DrawTexturePro(enemy.texture, sourceRec, destRec, { 0, 0 }, 0.0f, WHITE);
+    } else {
+        DrawCircleV(position, tileWidth / 2.5f, enemy.color);
+    }
+}
+
+static void DrawHpBar(Vector2 position, float hpRatio, bool outlined) {
+    DrawRectangle(position.x - 15, position.y - tileHeight / 2 - 10, 30, 5, RED);
+    DrawRectangle(position.x - 15, position.y - tileHeight / 2 - 10, 30 * hpRatio, 5, GREEN);
+    if (outlined) DrawRectangleLines(position.x - 15, position.y - tileHeight / 2 - 10, 30, 5, BLACK);
+}
+
+static void DrawEnemySwarm(const RenderSnapshot& snapshot, int minCol, int maxCol, int minRow, int maxRow, bool showHpBars, bool showBadges) {
+    sort(swarmEntries.begin(), swarmEntries.end(), [](const SwarmEntry& a, const SwarmEntry& b) {
+        return a.cell != b.cell ? a.cell < b.cell : a.enemyIndex < b.enemyIndex;
+    });
+    // Each route once, from the least advanced enemy on it
+    static unordered_map<const PathRoute*, int> routeStarts;
+    routeStarts.clear();
+    for (const auto& entry : swarmEntries) {
+        const EnemySprite& enemy = snapshot.enemies[entry.enemyIndex];
+        if (enemy.route == nullptr) continue;
+        auto inserted = routeStarts.emplace(enemy.route.get(), enemy.routeSegment);
+        if (!inserted.second) inserted.first->second = min(inserted.first->second, enemy.routeSegment);
+    }
+    // Routes overlap heavily once enemies have re-pathed, so each tile-to-tile step is drawn once
+    // however many routes share it. Bit 4 of a tile's mask is its node dot, the rest are the steps out.
+    // Only steps from tiles in the drawn window count, so the mask covers the window, not the map
+    static vector<uint16_t> drawnSteps;
+    int windowColumns = maxCol - minCol + 1;
+    drawnSteps.assign((size_t)windowColumns * (maxRow - minRow + 1), 0);
+    Color pathColor = ColorAlpha(LIGHTGRAY, 0.3f);
+    for (const auto& routeStart : routeStarts) {
+        const vector<Vector2>& points = routeStart.first->points;
+        for (size_t i = routeStart.second + 1; i < points.size(); ++i) {
+            Vector2Int tile = GetGridCoords(points[i]);
+            if (tile.x < minCol || tile.x > maxCol || tile.y < minRow || tile.y > maxRow) continue;
+            uint16_t& marks = drawnSteps[(size_t)(tile.y - minRow) * windowColumns + (tile.x - minCol)];
+            if (!(marks & (1 << 4))) {
+                marks |= 1 << 4;
+                DrawCircleV(points[i], 3.0f, pathColor);
+            }
+            if (i + 1 == points.size()) break;
+            Vector2Int next = GetGridCoords(points[i + 1]);
+            int step = (clamp(next.y - tile.y, -1, 1) + 1) * 3 + clamp(next.x - tile.x, -1, 1) + 1;
+            if (marks & (1 << step)) continue;
+            marks |= 1 << step;
+            DrawLineEx(points[i], points[i + 1], 2.0f, pathColor);
+        }
+    }
+    for (size_t begin = 0; begin < swarmEntries.size();) {
+        size_t end = begin + 1;
+        while (end < swarmEntries.size() && swarmEntries[end].cell == swarmEntries[begin].cell) end++;
+        const EnemySprite& first = snapshot.enemies[swarmEntries[begin].enemyIndex];
+        int count = (int)(end - begin);
+        if (count == 1) {
+            DrawEnemySprite(first, first.position);
+            if (showHpBars) DrawHpBar(first.position, first.hpRatio, false);
         } else {
-            DrawCircleV(enemy.position, tileWidth / 2.5f, enemy.color);
+            Vector2 center = { 0.0f, 0.0f };
+            float hpRatioSum = 0.0f;
+            for (size_t i = begin; i < end; i++) {
+                const EnemySprite& enemy = snapshot.enemies[swarmEntries[i].enemyIndex];
+                center = Vector2Add(center, enemy.position);
+                hpRatioSum += enemy.hpRatio;
+            }
+            center = Vector2Scale(center, 1.0f / count);
+            DrawEnemySprite(first, center);
+            if (showHpBars) DrawHpBar(center, hpRatioSum / count, false);
+            if (showBadges) {
+                const char* badge = TextFormat("%d", count);
+                int badgeWidth = MeasureText(badge, 10) + 6;
+                DrawRectangle(center.x + tileWidth / 4, center.y - tileHeight / 2, badgeWidth, 12, ColorAlpha(BLACK, 0.7f));
+                DrawText(badge, center.x + tileWidth / 4 + 3, center.y - tileHeight / 2 + 1, 10, WHITE);
+            }
         }
-        float hpRatio = (float)enemy.hp / enemy.maxHp;
-        DrawRectangle(enemy.position.x - 15, enemy.position.y - tileHeight / 2 - 10, 30, 5, RED);
-        DrawRectangle(enemy.position.x - 15, enemy.position.y - tileHeight / 2 - 10, 30 * hpRatio, 5, GREEN);
-        DrawRectangleLines(enemy.position.x - 15, enemy.position.y - tileHeight / 2 - 10, 30, 5, BLACK);
+        begin = end;
+    }
+}
+
+void DrawEnemies(const RenderSnapshot& snapshot) {
+    TraceScope trace("DrawEnemies");
+    // Only enemies on visible tiles (plus a tile of margin for sprites hanging over the edge)
+    int minCol, maxCol, minRow, maxRow;
+    GetVisibleTileRange(minCol, maxCol, minRow, maxRow);
+    minCol--;
+    maxCol++;
+    minRow--;
+    maxRow++;
+    swarmEntries.clear();
+    for (int i = 0; i < (int)snapshot.enemies.size(); i++) {
+        Vector2Int tile = GetGridCoords(snapshot.enemies[i].position);
+        if (tile.x < minCol || tile.x > maxCol || tile.y < minRow || tile.y > maxRow) continue;
+        swarmEntries.push_back({ tile.y * gridColumns + tile.x, i });
+    }
+    UpdateEnemyLod((int)swarmEntries.size());
+    // HP bars are 5 world units tall and badges 10; below about two pixels they are noise
+    bool showHpBars = 5.0f * camera.zoom >= 2.0f;
+    bool showBadges = 10.0f * camera.zoom >= 6.0f;
+    if (enemyLodActive) {
+        DrawEnemySwarm(snapshot, minCol, maxCol, minRow, maxRow, showHpBars, showBadges);
+        return;
+    }
+
+    // First draw all enemy paths for better layering
+    for (const auto& entry : swarmEntries) {
+        const EnemySprite& enemy = snapshot.enemies[entry.enemyIndex];
+        if (enemy.route != nullptr) DrawRoutePath(*enemy.route, enemy.routeSegment, enemy.color);
+    }
+
+    // Then draw all enemies over the paths
+    for (const auto& entry : swarmEntries) {
+        const EnemySprite& enemy = snapshot.enemies[entry.enemyIndex];
+        DrawEnemySprite(enemy, enemy.position);
+        if (showHpBars) DrawHpBar(enemy.position, enemy.hpRatio, true);
     }
 }
 
 void UpdateProjectiles() {
-    for (auto& projectile : projectiles) {
-        if (!projectile.active || !projectile.targetEnemy->active) {
-            projectile.active = false;
-            continue;
-        }
-        Vector2 direction = Vector2Subtract(projectile.targetEnemy->position, projectile.position);
-        float distance = Vector2Length(direction);
-        if (distance < 5.0f) {
-            if (projectile.type == Projectile::Type::STANDARD) {
-                int actualDamage = (projectile.targetEnemy->type == ARMOURED_ENEMY || projectile.targetEnemy->type == FAST_ARMOURED_ENEMY) ? (int)(projectile.damage * 0.7f) : projectile.damage;
-                projectile.targetEnemy->hp -= actualDamage;
-                if (projectile.targetEnemy->hp <= 0) {
-                    projectile.targetEnemy->active = false;
-                    playerMoney += 10;
-                    defeatedEnemies++;
-                }
-                projectile.active = false;
-            } else if (projectile.type == Projectile::Type::FLAMETHROWER) {
-                VisualEffect explosion = { projectile.position, 0.5f, 0.5f, ColorAlpha(ORANGE, 0.8f), projectile.effectRadius, true };
-                visualEffects.push_back(explosion);
-                for (auto& enemy : enemies) {
-                    if (!enemy.active) continue;
-                    float enemyDistance = Vector2Distance(projectile.position, enemy.position);
-                    if (enemyDistance <= projectile.effectRadius) {
+    TraceScope trace("UpdateProjectiles");
+    // Standard and splash shots share the columns they have in common; the splash column is only
+    // present in archetypes whose projectiles carry it. Spent projectiles are destroyed after the walk.
+    static vector<Archetype*> projectileArchetypes;
+    static vector<EntityHandle> spentProjectiles;
+    spentProjectiles.clear();
+    QueryArchetypes(ComponentBit(COMPONENT_POSITION) | ComponentBit(COMPONENT_PROJECTILE), projectileArchetypes);
+    for (Archetype* archetype : projectileArchetypes) {
+        Vector2* positions = GetComponentColumn<Vector2>(*archetype, COMPONENT_POSITION);
+        const ProjectileComponent* projectiles = GetComponentColumn<ProjectileComponent>(*archetype, COMPONENT_PROJECTILE);
+        const SplashComponent* splashes = GetComponentColumn<SplashComponent>(*archetype, COMPONENT_SPLASH);
+        for (size_t row = 0; row < archetype->entities.size(); row++) {
+            const ProjectileComponent& projectile = projectiles[row];
+            Vector2& position = positions[row];
+            Enemy* targetEnemy = FindEnemyById(projectile.targetEnemyId);
+            if (targetEnemy == nullptr || !targetEnemy->active) {
+                spentProjectiles.push_back(archetype->entities[row]);
+                continue;
+            }
+            Vector2 direction = Vector2Subtract(targetEnemy->position, position);
+            float distance = Vector2Length(direction);
+            if (distance < 5.0f) {
+                if (splashes == nullptr) {
+                    int actualDamage = (targetEnemy->type == ARMOURED_ENEMY || targetEnemy->type == FAST_ARMOURED_ENEMY) ? (int)(projectile.damage * 0.7f) : projectile.damage;
+                    targetEnemy->hp -= actualDamage;
+                    RecordTowerDamage(projectile.sourceTower, DAMAGE_DIRECT, actualDamage, targetEnemy->hp);
+                    if (targetEnemy->hp <= 0) {
+                        targetEnemy->active = false;
+                        playerMoney += 10;
+                        defeatedEnemies++;
+                    }
+                } else {
+                    float radius = splashes[row].radius;
+                    SpawnVisualEffect({ position, 0.5f, 0.5f, ColorAlpha(ORANGE, 0.8f), radius, true });
+                    static vector<int> splashHits;
+                    QueryEnemiesInRadius(position, radius, splashHits);
+                    for (int enemyIndex : splashHits) {
+                        Enemy& enemy = enemies[enemyIndex];
                         int initialDamage = (enemy.type == ARMOURED_ENEMY || enemy.type == FAST_ARMOURED_ENEMY) ? (int)(projectile.damage / 3 * 0.7f) : projectile.damage / 3;
                         enemy.hp -= initialDamage;
-                        enemy.hasDotEffect = true;
-                        enemy.dotTimer = 4.0f;
-                        enemy.dotTickTimer = 0.5f;
-                        enemy.dotDamage = projectile.damage / 8;
+                        RecordTowerDamage(projectile.sourceTower, DAMAGE_SPLASH, initialDamage, enemy.hp);
+                        ApplyEnemyBurning(enemy, 4.0f, projectile.damage / 8, projectile.sourceTower);
                         if (enemy.hp <= 0) {
                             enemy.active = false;
                             playerMoney += 10;
@@ -241,18 +565,22 @@ void UpdateProjectiles() {
                         }
                     }
                 }
-                projectile.active = false;
+                spentProjectiles.push_back(archetype->entities[row]);
+            } else {
+                Vector2 normalizedDir = Vector2Normalize(direction);
+                position = Vector2Add(position, Vector2Scale(normalizedDir, projectile.speed * simTickDuration));
+                if (splashes != nullptr) {
+                    // Trail of short-lived flames behind the stream
+                    SpawnVisualEffect({ position, 0.1f, 0.1f, ColorAlpha(ORANGE, 0.6f), 10.0f, true });
+                }
             }
-        } else {
-            Vector2 normalizedDir = Vector2Normalize(direction);
-            projectile.position = Vector2Add(projectile.position, Vector2Scale(normalizedDir, projectile.speed * GetFrameTime()));
         }
     }
+    for (EntityHandle entity : spentProjectiles) DestroyEntity(entity);
 }
 
-void DrawProjectiles() {
-    for (const auto& projectile : projectiles) {
-        if (!projectile.active) continue;
+void DrawProjectiles(const RenderSnapshot& snapshot) {
+    for (const auto& projectile : snapshot.projectiles) {
         if (projectile.type == Projectile::Type::STANDARD) {
             if (projectile.texture.id > 0) {
                 Rectangle sourceRec = { 0.0f, 0.0f, (float)projectile.texture.width, (float)projectile.texture.height };
@@ -263,8 +591,6 @@ void DrawProjectiles() {
             }
         } else if (projectile.type == Projectile::Type::FLAMETHROWER) {
             DrawLineEx(projectile.sourcePosition, projectile.position, 5.0f, ColorAlpha(ORANGE, 0.8f));
-            VisualEffect flame = { projectile.position, 0.1f, 0.1f, ColorAlpha(ORANGE, 0.6f), 10.0f, true };
-            visualEffects.push_back(flame);
         }
     }
 }
\ No newline at end of file
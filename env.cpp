@@ -0,0 +1,283 @@
+#include "game.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Batched game instances for automated agents. Game state lives in process globals, so every
+// instance runs in its own forked worker process: instances are isolated without any state
+// plumbing and step in parallel on as many cores as there are. The batch's actions sit in a
+// shared control block, and observations go straight into the caller's buffers, which must come
+// from AllocateEnvironmentBuffer so the workers can write them. A step is one byte down a pipe to
+// each worker and one byte back when it has finished its ticks and written its observation.
+// Create the batch before starting any threads; fork only carries the calling thread over.
+
+struct EnvControl {
+    int ticks;
+    int actionCount;
+    EnvAction actions[envMaxActionsPerStep];
+};
+
+static EnvControl* envControl = nullptr;
+static EnvObservation envObservation;
+static int envTileCount = 0;
+static vector<pid_t> envWorkers;
+static vector<int> envCommandFds;
+static vector<int> envDoneFds;
+static struct sigaction envPreviousSigpipe; // Restored when the batch is destroyed
+static bool envSigpipeIgnored = false;
+
+void* AllocateEnvironmentBuffer(size_t bytes) {
+    void* buffer = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        TraceLog(LOG_WARNING, "ENV: Cannot map %zu bytes of shared memory", bytes);
+        return nullptr;
+    }
+    return buffer;
+}
+
+void FreeEnvironmentBuffer(void* buffer, size_t bytes) {
+    if (buffer != nullptr) munmap(buffer, bytes);
+}
+
+static void StartEnvironmentGame() {
+    currentState = PLAYING;
+    ResetGame();
+}
+
+static bool ApplyEnvironmentAction(const EnvAction& action) {
+    if (action.type == ENV_ACTION_RESET) {
+        StartEnvironmentGame();
+        return true;
+    }
+    if (currentState != PLAYING) return false;
+    if (action.type == ENV_ACTION_PLACE_TOWER) return PlaceTower(action.towerType, action.tile);
+    int towerIndex = IsInsideGrid(action.tile.x, action.tile.y) ? GetTowerAtTile(action.tile) : -1;
+    if (action.type == ENV_ACTION_UPGRADE_TOWER) return UpgradeTower(towerIndex);
+    if (action.type == ENV_ACTION_ACTIVATE_ABILITY && towerIndex >= 0) {
+        Tower& tower = towers[towerIndex];
+        if (tower.abilityReadyTime > simTime || tower.abilityActive) return false;
+        ActivateTowerAbility(tower);
+        return true;
+    }
+    return false;
+}
+
+static int ApplyEnvironmentActions(int instance) {
+    // Actions apply in batch order; returns how many of this instance's were rejected
+    int rejected = 0;
+    for (int i = 0; i < envControl->actionCount; i++) {
+        const EnvAction& action = envControl->actions[i];
+        if (action.instance == instance && !ApplyEnvironmentAction(action)) rejected++;
+    }
+    return rejected;
+}
+
+static void WriteEnvironmentObservation(int instance, int rejectedActions) {
+    size_t base = (size_t)instance * envTileCount;
+    uint8_t* walkable = envObservation.walkable + base;
+    uint8_t* towerType = envObservation.towerType + base;
+    uint8_t* towerLevel = envObservation.towerLevel + base;
+    uint16_t* enemyCount = envObservation.enemyCount + base;
+    for (int row = 0; row < gridRows; row++) {
+        for (int col = 0; col < gridColumns; col++) {
+            int tile = row * gridColumns + col;
+            int towerIndex = towerAtTile[tile];
+            walkable[tile] = IsTileWalkable(col, row) ? 1 : 0;
+            towerType[tile] = (uint8_t)(towerIndex >= 0 ? towers[towerIndex].type : NONE);
+            towerLevel[tile] = (uint8_t)(towerIndex >= 0 ? towers[towerIndex].upgradeLevel : 0);
+        }
+    }
+    memset(enemyCount, 0, envTileCount * sizeof(uint16_t));
+    int aliveEnemies = 0;
+    for (const auto& enemy : enemies) {
+        if (!enemy.active) continue;
+        aliveEnemies++;
+        Vector2Int tile = GetGridCoords(enemy.position);
+        if (IsInsideGrid(tile.x, tile.y) && enemyCount[tile.y * gridColumns + tile.x] < UINT16_MAX) enemyCount[tile.y * gridColumns + tile.x]++;
+    }
+    EnvStatus& status = envObservation.status[instance];
+    status.money = playerMoney;
+    status.wave = currentWaveIndex;
+    status.aliveEnemies = aliveEnemies;
+    status.enemiesEscaped = enemiesReachedEnd;
+    status.waveEnemiesDefeated = defeatedEnemies;
+    status.towerCount = (int)towers.size();
+    status.rejectedActions = rejectedActions;
+    status.state = currentState;
+    status.simTime = simTime;
+}
+
+static void RunEnvironmentWorker(int instance, int commandFd, int doneFd) {
+    WriteEnvironmentObservation(instance, 0);
+    char command;
+    while (read(commandFd, &command, 1) == 1) {
+        int rejected = ApplyEnvironmentActions(instance);
+        for (int tick = 0; tick < envControl->ticks && currentState == PLAYING; tick++) StepSimulation();
+        WriteEnvironmentObservation(instance, rejected);
+        if (write(doneFd, &command, 1) != 1) break;
+    }
+    // The batch was destroyed (or the parent died) and the pipe closed
+    _exit(0);
+}
+
+int GetEnvironmentTileCount(const EnvBatchConfig& config) {
+    return config.columns * config.rows;
+}
+
+bool CreateEnvironmentBatch(const EnvBatchConfig& config, const EnvObservation& observation) {
+    if (!envWorkers.empty() || config.instanceCount <= 0) return false;
+    if (IsSimulationThreadRunning() || AreAssetWorkersRunning() || IsTelemetryRunning()) {
+        // A forked worker would hold copies of their locks and rings with no thread behind them
+        TraceLog(LOG_WARNING, "ENV: A batch must be created before the game starts any threads");
+        return false;
+    }
+    if (config.columns < defaultGridColumns || config.rows < defaultGridRows) {
+        TraceLog(LOG_WARNING, "ENV: A batch needs at least a %dx%d grid", defaultGridColumns, defaultGridRows);
+        return false;
+    }
+    currentDifficulty = config.difficulty;
+    builtinMapColumns = config.columns;
+    builtinMapRows = config.rows;
+    endlessMode = config.endless;
+    // Load the map once here so the workers start from a copy of it
+    StartEnvironmentGame();
+    if (gridColumns != config.columns || gridRows != config.rows) {
+        TraceLog(LOG_WARNING, "ENV: The map is %dx%d, not the %dx%d the batch was sized for", gridColumns, gridRows, config.columns, config.rows);
+        return false;
+    }
+    envControl = (EnvControl*)AllocateEnvironmentBuffer(sizeof(EnvControl));
+    if (envControl == nullptr) return false;
+    envControl->ticks = 0;
+    envControl->actionCount = 0;
+    envObservation = observation;
+    envTileCount = GetEnvironmentTileCount(config);
+    // Writes to a worker that has died should fail the step, not kill the caller
+    struct sigaction ignoreSigpipe = {};
+    ignoreSigpipe.sa_handler = SIG_IGN;
+    sigemptyset(&ignoreSigpipe.sa_mask);
+    envSigpipeIgnored = sigaction(SIGPIPE, &ignoreSigpipe, &envPreviousSigpipe) == 0;
+    for (int instance = 0; instance < config.instanceCount; instance++) {
+        int commandPipe[2] = { -1, -1 }, donePipe[2] = { -1, -1 };
+        if (pipe(commandPipe) != 0 || pipe(donePipe) != 0) {
+            TraceLog(LOG_WARNING, "ENV: Cannot create pipes for instance %d", instance);
+            for (int fd : { commandPipe[0], commandPipe[1], donePipe[0], donePipe[1] }) {
+                if (fd >= 0) close(fd);
+            }
+            DestroyEnvironmentBatch();
+            return false;
+        }
+        endlessSeed = config.seed + (uint32_t)instance;
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Only this instance's pipe ends stay open in the worker
+            close(commandPipe[1]);
+            close(donePipe[0]);
+            for (int fd : envCommandFds) close(fd);
+            for (int fd : envDoneFds) close(fd);
+            RunEnvironmentWorker(instance, commandPipe[0], donePipe[1]);
+        }
+        close(commandPipe[0]);
+        close(donePipe[1]);
+        if (pid < 0) {
+            TraceLog(LOG_WARNING, "ENV: Cannot start a worker for instance %d", instance);
+            close(commandPipe[1]);
+            close(donePipe[0]);
+            DestroyEnvironmentBatch();
+            return false;
+        }
+        envWorkers.push_back(pid);
+        envCommandFds.push_back(commandPipe[1]);
+        envDoneFds.push_back(donePipe[0]);
+    }
+    // Wait for every worker's first observation
+    return StepEnvironments(nullptr, 0, 0);
+}
+
+bool StepEnvironments(const EnvAction* actions, int actionCount, int ticks) {
+    if (envWorkers.empty() || actionCount < 0 || actionCount > envMaxActionsPerStep) return false;
+    envControl->ticks = ticks;
+    envControl->actionCount = actionCount;
+    if (actionCount > 0) memcpy(envControl->actions, actions, actionCount * sizeof(EnvAction));
+    // Every worker is started before any is waited on, so the instances step in parallel
+    char command = 's';
+    bool ok = true;
+    for (int fd : envCommandFds) ok = write(fd, &command, 1) == 1 && ok;
+    for (int fd : envDoneFds) ok = read(fd, &command, 1) == 1 && ok;
+    if (!ok) TraceLog(LOG_WARNING, "ENV: A worker process stopped responding");
+    return ok;
+}
+
+void DestroyEnvironmentBatch() {
+    // Closing the command pipes ends the workers' loops
+    for (int fd : envCommandFds) close(fd);
+    for (pid_t pid : envWorkers) waitpid(pid, nullptr, 0);
+    for (int fd : envDoneFds) close(fd);
+    envWorkers.clear();
+    envCommandFds.clear();
+    envDoneFds.clear();
+    FreeEnvironmentBuffer(envControl, sizeof(EnvControl));
+    envControl = nullptr;
+    if (envSigpipeIgnored) sigaction(SIGPIPE, &envPreviousSigpipe, nullptr);
+    envSigpipeIgnored = false;
+}
+
+int RunEnvironmentBenchmark(int instanceCount) {
+    // Random placement bots on every instance; reports sim ticks per second across the batch
+    EnvBatchConfig config = { instanceCount, MEDIUM, defaultGridColumns, defaultGridRows, false, 1 };
+    size_t tileCount = (size_t)instanceCount * GetEnvironmentTileCount(config);
+    const size_t bufferSizes[5] = { tileCount, tileCount, tileCount, tileCount * sizeof(uint16_t), instanceCount * sizeof(EnvStatus) };
+    void* buffers[5];
+    for (int i = 0; i < 5; i++) {
+        buffers[i] = AllocateEnvironmentBuffer(bufferSizes[i]);
+        if (buffers[i] == nullptr) return 1;
+    }
+    EnvObservation observation = { (uint8_t*)buffers[0], (uint8_t*)buffers[1], (uint8_t*)buffers[2], (uint16_t*)buffers[3], (EnvStatus*)buffers[4] };
+    if (!CreateEnvironmentBatch(config, observation)) return 1;
+
+    mt19937 rng(1);
+    vector<EnvAction> actions;
+    const int ticksPerStep = 60;
+    const int stepCount = 2000;
+    long long ticks = 0, rejected = 0, resets = 0;
+    vector<double> stepStartTimes(instanceCount, 0.0);
+    auto start = chrono::steady_clock::now();
+    for (int step = 0; step < stepCount; step++) {
+        actions.clear();
+        for (int instance = 0; instance < instanceCount; instance++) {
+            const EnvStatus& status = observation.status[instance];
+            rejected += status.rejectedActions;
+            // Only ticks the instance actually simulated count; a lost game stops ticking until reset
+            ticks += llround((status.simTime - stepStartTimes[instance]) / simTickDuration);
+            stepStartTimes[instance] = status.simTime;
+            if (status.state != PLAYING) {
+                actions.push_back({ instance, ENV_ACTION_RESET, NONE, { 0, 0 } });
+                stepStartTimes[instance] = 0.0;
+                resets++;
+                continue;
+            }
+            Vector2Int tile = { (int)(rng() % config.columns), (int)(rng() % config.rows) };
+            actions.push_back({ instance, ENV_ACTION_PLACE_TOWER, (TowerType)(TIER1_DEFAULT + rng() % 3), tile });
+            actions.push_back({ instance, ENV_ACTION_UPGRADE_TOWER, NONE, tile });
+        }
+        if (!StepEnvironments(actions.data(), (int)actions.size(), ticksPerStep)) break;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    long long towersPlaced = 0, wave = 0;
+    for (int instance = 0; instance < instanceCount; instance++) {
+        ticks += llround((observation.status[instance].simTime - stepStartTimes[instance]) / simTickDuration);
+        rejected += observation.status[instance].rejectedActions;
+        towersPlaced += observation.status[instance].towerCount;
+        wave += observation.status[instance].wave;
+    }
+    printf("Environment batch: %d instances, %lld ticks in %.2f s, %.0f ticks/s\n", instanceCount, ticks, seconds, ticks / seconds);
+    printf("  %lld resets, %lld rejected actions, %.1f towers and wave %.1f per instance at the end\n", resets, rejected,
+           (double)towersPlaced / instanceCount, (double)wave / instanceCount);
+    DestroyEnvironmentBatch();
+    for (int i = 0; i < 5; i++) FreeEnvironmentBuffer(buffers[i], bufferSizes[i]);
+    return 0;
+}
@@ -1,10 +1,13 @@
 #include "game.h"
 
 // Define global variables
-bool grid[gridRows][gridColumns];
+TileGrid grid;
+int gridColumns = defaultGridColumns;
+int gridRows = defaultGridRows;
+Camera2D camera = { { 0.0f, 0.0f }, { 0.0f, 0.0f }, 0.0f, 1.0f };
 vector<Tower> towers;
+vector<int> towerAtTile;
 vector<Enemy> enemies;
-vector<Projectile> projectiles;
 vector<Vector2> waypoints;
 vector<EnemyWave> waves = {
     {5, 0, 0, 0, 1.0f}, {3, 2, 0, 0, 0.8f}, {0, 5, 0, 0, 0.5f},
@@ -12,18 +15,19 @@ vector<EnemyWave> waves = {
     {5, 0, 5, 0, 0.8f}, {0, 5, 0, 3, 0.6f}, {0, 0, 5, 5, 0.3f},
     {10, 5, 5, 5, 0.5f}
 };
-vector<VisualEffect> visualEffects;
-vector<LaserBeam> laserBeams;
 vector<WeatherParticle> weatherParticles;
 int playerMoney = 100;
 TowerType selectedTowerType = NONE;
 int currentWaveIndex = 0;
-float waveTimer = 0.0f;
+double waveStartTime = 0.0;
 float waveDelay = 15.0f;
 bool waveInProgress = false;
 int spawnedEnemies = 0;
 int defeatedEnemies = 0;
 int enemiesReachedEnd = 0;
+int nextEnemyId = 0;
+int gridVersion = 0;
+vector<int> goalDistanceField;
 GameState currentState = MENU;
 int selectedTowerIndex = -1;
 MapDifficulty currentDifficulty = EASY;
@@ -31,7 +35,6 @@ WeatherType currentWeather = WEATHER_NONE;
 Texture2D tier1TowerTexture;
 Texture2D tier2TowerTexture;
 Texture2D tier3TowerTexture;
-Texture2D placeholderTexture;
 Texture2D tier1ProjectileTexture;
 Texture2D tier2ProjectileTexture;
 Texture2D tier3ProjectileTexture;
@@ -49,72 +52,110 @@ Rectangle pauseButton = { 10, 10, 30, 30 };
 bool isPaused = false;
 Rectangle skipWaveButton;
 bool showSkipButton = false;
+Rectangle speedButton = { screenWidth - 180, 5, 55, 26 };
+SimSpeed currentSimSpeed = SPEED_1X;
+double simTime = 0.0;
+float simAccumulator = 0.0f;
+float frameTimeTarget = defaultFrameTimeTarget;
+double lastFrameWorkTime = 0.0; // Previous frame from input to just before EndDrawing, without the vsync wait or the wait for the sim thread
 
 void InitGrid() {
-    for (int row = 0; row < gridRows; ++row) {
-        for (int col = 0; col < gridColumns; ++col) {
-            grid[row][col] = true;
-        }
-    }
-    if (currentDifficulty == MEDIUM) {
-        for (int row = 2; row < 4; row++) {
-            for (int col = 2; col < 6; col++) {
-                grid[row][col] = false;
-            }
-        }
-        grid[6][4] = false; grid[6][5] = false;
-        grid[7][4] = false; grid[7][5] = false;
-    } else if (currentDifficulty == HARD) {
-        for (int col = 2; col < 5; col++) grid[2][col] = false;
-        for (int col = 10; col < 13; col++) grid[2][col] = false;
-        for (int col = 4; col < 7; col++) grid[4][col] = false;
-        for (int col = 8; col < 11; col++) grid[6][col] = false;
-        for (int row = 6; row < 8; row++) grid[row][3] = false;
-    }
+    LoadCurrentMap();
+    const MapFileHeader* header = currentMap.header;
+    InitTileGrid(header->columns, header->rows);
+    grid.chunks.assign(currentMap.walkableChunks, currentMap.walkableChunks + (size_t)header->chunkColumns * header->chunkRows);
+    currentWeather = (WeatherType)header->weather;
+}
+
+Vector2 GetSpawnPoint() {
+    return GetTileCenter(GetMapSpawnTile());
 }
 
 void InitWaypoints() {
+    // Static route shown on the board and followed by enemies that have no path of their own
     waypoints.clear();
-    
-    // Use the same "easy" path for all difficulty levels
-    int pathRow = gridRows / 2;
-    for (int col = 0; col < gridColumns; ++col) {
-        waypoints.push_back({ (float)(col * tileWidth + tileWidth / 2), (float)(pathRow * tileHeight + tileHeight / 2) });
+    for (const auto& tile : FindPathToGoal(GetMapSpawnTile())) {
+        waypoints.push_back(GetTileCenter(tile));
+    }
+    if (waypoints.empty()) {
+        waypoints.push_back(GetSpawnPoint());
+        waypoints.push_back(GetTileCenter(GetMapGoalTile()));
     }
-    
-    // Original code with different paths per difficulty has been replaced
 }
 
 void ResetGame() {
+    RecordTelemetryReset();
     towers.clear();
     enemies.clear();
-    projectiles.clear();
+    BuildEnemyQueryIndex(); // Drop per-tick indices that point into the old enemy list
+    BuildEnemyProgressIndex();
+    ResetPathRequests();
     weatherParticles.clear();
-    laserBeams.clear();
-    visualEffects.clear();
+    ClearEntities();
     if (currentDifficulty == EASY) playerMoney = 120;
     else if (currentDifficulty == MEDIUM) playerMoney = 100;
     else if (currentDifficulty == HARD) playerMoney = 80;
     selectedTowerType = NONE;
     currentWaveIndex = 0;
-    waveTimer = 0.0f;
+    waveStartTime = 0.0;
+    currentTimeline = {};
     waveDelay = 15.0f;
     waveInProgress = false;
     spawnedEnemies = 0;
     defeatedEnemies = 0;
     enemiesReachedEnd = 0;
+    nextEnemyId = 0;
+    simTime = 0.0;
+    simAccumulator = 0.0f;
+    camera.target = { 0.0f, 0.0f };
+    camera.zoom = 1.0f;
     selectedTowerIndex = -1;
     InitGrid();
+    RebuildTowerTileIndex();
+    ResetTowerCoverage();
+    ResetTowerDeadlines();
+    NotifyGridChanged();
     InitWaypoints();
+    ResetRenderSnapshots();
+}
+
+Vector2 GetMouseWorldPosition() {
+    return GetScreenToWorld2D(GetMousePosition(), camera);
+}
+
+void UpdateMapCamera() {
+    // Pan with the arrow keys and zoom with the wheel; maps that fit the screen stay pinned at the origin
+    float dt = GetFrameTime();
+    if (IsKeyDown(KEY_RIGHT)) camera.target.x += cameraPanSpeed * dt / camera.zoom;
+    if (IsKeyDown(KEY_LEFT)) camera.target.x -= cameraPanSpeed * dt / camera.zoom;
+    if (IsKeyDown(KEY_DOWN)) camera.target.y += cameraPanSpeed * dt / camera.zoom;
+    if (IsKeyDown(KEY_UP)) camera.target.y -= cameraPanSpeed * dt / camera.zoom;
+    float wheel = GetMouseWheelMove();
+    if (wheel != 0.0f) camera.zoom = Clamp(camera.zoom * (1.0f + 0.1f * wheel), minCameraZoom, maxCameraZoom);
+    float viewWidth = screenWidth / camera.zoom;
+    float viewHeight = screenHeight / camera.zoom;
+    float worldWidth = (float)(gridColumns * tileWidth);
+    float worldHeight = (float)(gridRows * tileHeight);
+    camera.target.x = worldWidth > viewWidth ? Clamp(camera.target.x, 0.0f, worldWidth - viewWidth) : 0.0f;
+    camera.target.y = worldHeight > viewHeight ? Clamp(camera.target.y, 0.0f, worldHeight - viewHeight) : 0.0f;
+}
+
+void GetVisibleTileRange(int& minCol, int& maxCol, int& minRow, int& maxRow) {
+    Vector2 topLeft = GetScreenToWorld2D({ 0.0f, 0.0f }, camera);
+    Vector2 bottomRight = GetScreenToWorld2D({ (float)screenWidth, (float)screenHeight }, camera);
+    minCol = clamp((int)(topLeft.x / tileWidth), 0, gridColumns - 1);
+    maxCol = clamp((int)(bottomRight.x / tileWidth), 0, gridColumns - 1);
+    minRow = clamp((int)(topLeft.y / tileHeight), 0, gridRows - 1);
+    maxRow = clamp((int)(bottomRight.y / tileHeight), 0, gridRows - 1);
 }
 
 void DrawGridHighlight() {
-    Vector2 mousePos = GetMousePosition();
-    int gridCol = mousePos.x / tileWidth;
-    int gridRow = mousePos.y / tileHeight;
-    if (gridCol >= 0 && gridCol < gridColumns && gridRow >= 0 && gridRow < gridRows) {
+    Vector2Int mouseTile = GetGridCoords(GetMouseWorldPosition());
+    int gridCol = mouseTile.x;
+    int gridRow = mouseTile.y;
+    if (IsInsideGrid(gridCol, gridRow)) {
         Rectangle highlightRect = { (float)gridCol * tileWidth, (float)gridRow * tileHeight, (float)tileWidth, (float)tileHeight };
-        if (grid[gridRow][gridCol]) {
+        if (IsTileWalkable(gridCol, gridRow)) {
             DrawRectangleRec(highlightRect, ColorAlpha(WHITE, 0.2f));
             DrawRectangleLinesEx(highlightRect, 1.0f, ColorAlpha(WHITE, 0.5f));
         } else {
@@ -124,59 +165,27 @@ void DrawGridHighlight() {
 }
 
 void UpdateGameElements() {
+    TraceScope trace("UpdateGameElements");
+    SetAllocationTag(ALLOC_PATHS);
+    ProcessPathRequests();
+    SetAllocationTag(ALLOC_ENEMIES);
     UpdateEnemies();
+    UpdateEnemyTileOccupancy();
+    BuildEnemyQueryIndex();
+    BuildEnemyProgressIndex();
+    ProcessEscapedEnemies();
+    SetAllocationTag(ALLOC_TOWERS);
     HandleTowerFiring();
+    SetAllocationTag(ALLOC_EFFECTS);
     UpdateProjectiles();
-    for (auto& effect : visualEffects) {
-        if (effect.active) {
-            effect.timer -= GetFrameTime();
-            if (effect.timer <= 0.0f) effect.active = false;
-        }
-    }
-    for (auto& beam : laserBeams) {
-        if (beam.active) {
-            beam.timer -= GetFrameTime();
-            if (beam.timer <= 0.0f) beam.active = false;
-        }
-    }
-    visualEffects.erase(remove_if(visualEffects.begin(), visualEffects.end(), [](const VisualEffect& e) { return !e.active; }), visualEffects.end());
-    laserBeams.erase(remove_if(laserBeams.begin(), laserBeams.end(), [](const LaserBeam& b) { return !b.active; }), laserBeams.end());
-    for (auto& tower : towers) {
-        if (tower.abilityCooldownTimer > 0.0f) tower.abilityCooldownTimer -= GetFrameTime();
-        if (tower.abilityActive) {
-            tower.abilityTimer -= GetFrameTime();
-            if (tower.abilityTimer <= 0.0f) {
-                tower.abilityActive = false;
-                if (tower.type == TIER2_FAST) tower.fireRate = tower.originalFireRate;
-            }
-        }
-    }
-    for (auto& enemy : enemies) {
-        if (!enemy.active) continue;
-        if (enemy.isSlowed) {
-            enemy.slowTimer -= GetFrameTime();
-            if (enemy.slowTimer <= 0.0f) {
-                enemy.isSlowed = false;
-                enemy.speed = enemy.originalSpeed;
-            }
-        }
-        if (enemy.hasDotEffect) {
-            enemy.dotTimer -= GetFrameTime();
-            enemy.dotTickTimer -= GetFrameTime();
-            if (enemy.dotTickTimer <= 0.0f) {
-                enemy.hp -= enemy.dotDamage;
-                enemy.dotTickTimer = 0.5f;
-                if (enemy.hp <= 0) {
-                    enemy.active = false;
-                    playerMoney += 10;
-                    defeatedEnemies++;
-                }
-            }
-            if (enemy.dotTimer <= 0.0f) enemy.hasDotEffect = false;
-        }
-    }
-    enemies.erase(remove_if(enemies.begin(), enemies.end(), [](const Enemy& e) { return !e.active; }), enemies.end());
-    projectiles.erase(remove_if(projectiles.begin(), projectiles.end(), [](const Projectile& p) { return !p.active; }), projectiles.end());
+    UpdateEffectLifetimes();
+    SetAllocationTag(ALLOC_TOWERS);
+    ProcessTowerDeadlines();
+    SetAllocationTag(ALLOC_ENEMIES);
+    // Statuses have always advanced twice a tick (here and in UpdateEnemies); slow and burn
+    // durations are tuned for that, so both steps stay
+    UpdateEnemyStatuses();
+    CompactEnemies();
 }
 
 void HandleTowerMenuClick() {
@@ -265,17 +274,14 @@ void DrawMenuScreen() {
     if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
         if (CheckCollisionPointRec(mp, easyButton)) {
             currentDifficulty = EASY;
-            currentWeather = WEATHER_NONE;
             currentState = PLAYING;
             ResetGame();
         } else if (CheckCollisionPointRec(mp, mediumButton)) {
             currentDifficulty = MEDIUM;
-            currentWeather = RAIN;
             currentState = PLAYING;
             ResetGame();
         } else if (CheckCollisionPointRec(mp, hardButton)) {
             currentDifficulty = HARD;
-            currentWeather = SNOW;
             currentState = PLAYING;
             ResetGame();
         }
@@ -291,42 +297,64 @@ void DrawMenuScreen() {
     }
 }
 
-void DrawGameElements() {
-    DrawTowers();
-    DrawEnemies();
-    DrawProjectiles();
-    DrawVisualEffects();
-    for (const auto& beam : laserBeams) {
+void DrawGameElements(const RenderSnapshot& snapshot) {
+    DrawTowers(snapshot);
+    DrawEnemies(snapshot);
+    DrawProjectiles(snapshot);
+    DrawVisualEffects(snapshot);
+    for (const auto& beam : snapshot.laserBeams) {
         if (beam.active) DrawLineEx(beam.start, beam.end, beam.thickness, beam.color);
     }
 }
 
+static Rectangle GetRepairButtonRect() {
+    return { (float)selectedTowerInfoX, (float)(selectedTowerInfoY + infoSpacing * 10), 150, 40 };
+}
+
 void DrawSelectedTowerInfo() {
     if (selectedTowerIndex >= 0 && selectedTowerIndex < towers.size()) {
-        Tower& tower = towers[selectedTowerIndex];
+        const Tower& tower = towers[selectedTowerIndex];
         DrawText(GetTowerName(tower.type), selectedTowerInfoX, selectedTowerInfoY, 20, BLACK);
         DrawText(TextFormat("Damage: %d", tower.damage), selectedTowerInfoX, selectedTowerInfoY + infoSpacing, 18, BLACK);
         DrawText(TextFormat("Range: %.0f", tower.range), selectedTowerInfoX, selectedTowerInfoY + infoSpacing * 2, 18, BLACK);
         DrawText(TextFormat("Fire Rate: %.1f", tower.fireRate), selectedTowerInfoX, selectedTowerInfoY + infoSpacing * 3, 18, BLACK);
         DrawText(TextFormat("Level: %d", tower.upgradeLevel + 1), selectedTowerInfoX, selectedTowerInfoY + infoSpacing * 4, 18, BLACK);
-        HandleTowerUpgrade();
-        HandleTowerAbilityButton();
+        DrawTargetingPolicyButton(tower);
+        DrawTowerUpgradeButton(tower);
+        DrawTowerAbilityButton(tower);
         if (tower.isMalfunctioning) {
-            Rectangle repairButton = { (float)selectedTowerInfoX, (float)(selectedTowerInfoY + infoSpacing * 10), 150, 40 };
+            Rectangle repairButton = GetRepairButtonRect();
             DrawRectangleRec(repairButton, ORANGE);
             DrawRectangleLinesEx(repairButton, 2.0f, BLACK);
             DrawText("Repair ($50)", repairButton.x + 10, repairButton.y + 10, 18, BLACK);
-            if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(GetMousePosition(), repairButton)) {
-                RepairTower(tower);
-            }
         }
     }
 }
 
+void HandleSelectedTowerPanel() {
+    // Input for the side panel, kept apart from its drawing so the panel can come from the HUD cache
+    if (selectedTowerIndex < 0 || selectedTowerIndex >= towers.size()) return;
+    HandleTargetingPolicyButton();
+    HandleTowerUpgrade();
+    HandleTowerAbilityButton();
+    Tower& tower = towers[selectedTowerIndex];
+    if (tower.isMalfunctioning && IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(GetMousePosition(), GetRepairButtonRect())) {
+        RepairTower(tower);
+    }
+}
+
+int GetWaveLeaderMarkerX() {
+    // Leading enemy marker: how far the front of the wave has pushed from spawn towards the goal
+    const Enemy* leader = GetLeadingEnemy();
+    int spawnDistance = GetGoalDistance(GetGridCoords(GetSpawnPoint()));
+    if (leader == nullptr || spawnDistance <= 0) return -1;
+    float leadProgress = Clamp(1.0f - GetEnemyRemainingDistance(*leader) / (spawnDistance * tileWidth), 0.0f, 1.0f);
+    return progressBarX + (int)(progressBarWidth * leadProgress);
+}
+
 void DrawWaveProgressBar() {
-    if (!waveInProgress || currentWaveIndex >= waves.size()) return;
-    const EnemyWave& currentWave = waves[currentWaveIndex];
-    int totalEnemies = currentWave.basicCount + currentWave.fastCount + currentWave.armouredCount + currentWave.fastArmouredCount;
+    if (!waveInProgress) return;
+    int totalEnemies = currentTimeline.totalCount;
     if (totalEnemies <= 0) return;
     float spawnProgress = (float)spawnedEnemies / totalEnemies;
     float defeatProgress = (float)defeatedEnemies / totalEnemies;
@@ -338,6 +366,52 @@ void DrawWaveProgressBar() {
     DrawRectangleLinesEx((Rectangle){(float)progressBarX, (float)progressBarY, (float)progressBarWidth, (float)progressBarHeight}, 2, BLACK);
     DrawText(TextFormat("Spawned: %d/%d", spawnedEnemies, totalEnemies), progressBarX, progressBarY + progressBarHeight + 5, 15, BLUE);
     DrawText(TextFormat("Defeated: %d/%d", defeatedEnemies, totalEnemies), progressBarX + 120, progressBarY + progressBarHeight + 5, 15, GREEN);
+    DrawText(TextFormat("Alive: %d", GetAliveEnemyCount()), progressBarX, progressBarY + progressBarHeight + 22, 15, RED);
+}
+
+void DrawWaveLeaderMarker() {
+    // Moves with the leading enemy nearly every frame, so it is drawn over the cached HUD instead of into it
+    if (!waveInProgress || currentTimeline.totalCount <= 0) return;
+    int markerX = GetWaveLeaderMarkerX();
+    if (markerX >= 0) DrawRectangle(markerX - 1, progressBarY - 3, 3, progressBarHeight + 6, RED);
+}
+
+void DrawHud() {
+    DrawText("Tower Defense", titleX - MeasureText("Tower Defense", 20) / 2, titleY, 20, MAROON);
+    DrawText(TextFormat("Money: %d", playerMoney), moneyX, moneyY, regularTextFontSize, textColor);
+    DrawText(TextFormat("Escaped: %d/%d", enemiesReachedEnd, maxEnemiesReachedEnd), escapedX, escapedY, regularTextFontSize, RED);
+    if (waveInProgress) {
+        int enemiesRemaining = currentTimeline.totalCount - spawnedEnemies + GetAliveEnemyCount();
+        DrawText(TextFormat("Wave %d - Enemies Remaining: %d", currentWaveIndex + 1, enemiesRemaining), waveInfoX, waveInfoY, regularTextFontSize, textColor);
+    } else if (HasWave(currentWaveIndex)) {
+        const char* nextWaveText = TextFormat("Next Wave in %d", (int)waveDelay + 1);
+        DrawText(nextWaveText, screenWidth / 2 - MeasureText(nextWaveText, largeTextFontSize) / 2, nextWaveTimerY, largeTextFontSize, BLUE);
+    } else {
+        DrawText("All Waves Completed!", waveInfoX, waveInfoY, regularTextFontSize, GREEN);
+    }
+    int currentMenuX = towerMenuStartX;
+    Rectangle tier1Rec = { (float)currentMenuX, (float)towerMenuStartY, (float)towerSelectionWidth, (float)towerSelectionHeight };
+    DrawRectangleRec(tier1Rec, BLUE);
+    DrawRectangleLinesEx(tier1Rec, 2.0f, selectedTowerType == TIER1_DEFAULT ? GOLD : DARKGRAY);
+    DrawText(GetTowerName(TIER1_DEFAULT), currentMenuX + 10, towerMenuStartY + 10, towerTypeTextSize, WHITE);
+    DrawText(TextFormat("$%d", GetTowerCost(TIER1_DEFAULT)), currentMenuX + 10, towerMenuStartY + towerSelectionHeight - 25, regularTextFontSize, WHITE);
+    currentMenuX += towerMenuSpacingX;
+    Rectangle tier2Rec = { (float)currentMenuX, (float)towerMenuStartY, (float)towerSelectionWidth, (float)towerSelectionHeight };
+    DrawRectangleRec(tier2Rec, GREEN);
+    DrawRectangleLinesEx(tier2Rec, 2.0f, selectedTowerType == TIER2_FAST ? GOLD : DARKGRAY);
+    DrawText(GetTowerName(TIER2_FAST), currentMenuX + 10, towerMenuStartY + 10, towerTypeTextSize, WHITE);
+    DrawText(TextFormat("$%d", GetTowerCost(TIER2_FAST)), currentMenuX + 10, towerMenuStartY + towerSelectionHeight - 25, regularTextFontSize, WHITE);
+    currentMenuX += towerMenuSpacingX;
+    Rectangle tier3Rec = { (float)currentMenuX, (float)towerMenuStartY, (float)towerSelectionWidth, (float)towerSelectionHeight };
+    DrawRectangleRec(tier3Rec, RED);
+    DrawRectangleLinesEx(tier3Rec, 2.0f, selectedTowerType == TIER3_STRONG ? GOLD : DARKGRAY);
+    DrawText(GetTowerName(TIER3_STRONG), currentMenuX + 10, towerMenuStartY + 10, towerTypeTextSize, WHITE);
+    DrawText(TextFormat("$%d", GetTowerCost(TIER3_STRONG)), currentMenuX + 10, towerMenuStartY + towerSelectionHeight - 25, regularTextFontSize, WHITE);
+    if (selectedTowerType != NONE) {
+        DrawText(TextFormat("Selected: %s", GetTowerName(selectedTowerType)), uiPadding, selectedTowerTextY, regularTextFontSize, GOLD);
+    }
+    DrawSelectedTowerInfo();
+    DrawWaveProgressBar();
 }
 
 void DrawPauseButton() {
@@ -353,7 +427,7 @@ void DrawPauseButton() {
 }
 
 void DrawSkipWaveButton() {
-    if (!waveInProgress && currentWaveIndex < waves.size() && waveDelay > 0.5f) {
+    if (!waveInProgress && HasWave(currentWaveIndex) && waveDelay > 0.5f) {
         showSkipButton = true;
         skipWaveButton = (Rectangle){ screenWidth - 120, 10, 110, 30 };
         DrawRectangleRec(skipWaveButton, DARKBLUE);
@@ -388,8 +462,49 @@ void DrawPauseScreen() {
     DrawText(instructionText, screenWidth / 2 - instructionWidth / 2, screenHeight / 2 + 20, 20, LIGHTGRAY);
 }
 
-void DrawVisualEffects() {
-    for (const auto& effect : visualEffects) {
+void SpawnVisualEffect(const VisualEffect& effect) {
+    EntityHandle entity = CreateEntity(ComponentBit(COMPONENT_POSITION) | ComponentBit(COMPONENT_LIFETIME) | ComponentBit(COMPONENT_FADING_CIRCLE));
+    *GetComponent<Vector2>(entity, COMPONENT_POSITION) = effect.position;
+    *GetComponent<LifetimeComponent>(entity, COMPONENT_LIFETIME) = { effect.lifespan, effect.timer };
+    *GetComponent<FadingCircleComponent>(entity, COMPONENT_FADING_CIRCLE) = { effect.color, effect.radius };
+}
+
+void SpawnLaserBeam(const LaserBeam& beam) {
+    EntityHandle entity = CreateEntity(ComponentBit(COMPONENT_LIFETIME) | ComponentBit(COMPONENT_BEAM));
+    *GetComponent<LifetimeComponent>(entity, COMPONENT_LIFETIME) = { beam.duration, beam.timer };
+    *GetComponent<BeamComponent>(entity, COMPONENT_BEAM) = { beam.start, beam.end, beam.color, beam.thickness };
+}
+
+void SpawnProjectile(const Projectile& projectile) {
+    // Splash is one more component, so a flamethrower shot is an ordinary projectile in another archetype
+    ComponentMask mask = ComponentBit(COMPONENT_POSITION) | ComponentBit(COMPONENT_PROJECTILE);
+    if (projectile.type == Projectile::Type::FLAMETHROWER) mask |= ComponentBit(COMPONENT_SPLASH);
+    EntityHandle entity = CreateEntity(mask);
+    *GetComponent<Vector2>(entity, COMPONENT_POSITION) = projectile.position;
+    *GetComponent<ProjectileComponent>(entity, COMPONENT_PROJECTILE) = { projectile.targetEnemyId, projectile.speed, projectile.damage,
+        projectile.texture, projectile.sourcePosition, projectile.sourceTower };
+    if (SplashComponent* splash = GetComponent<SplashComponent>(entity, COMPONENT_SPLASH)) splash->radius = projectile.effectRadius;
+}
+
+void UpdateEffectLifetimes() {
+    TraceScope trace("UpdateEffectLifetimes");
+    // One pass over every entity with a lifetime, whatever else it carries
+    static vector<Archetype*> lifetimeArchetypes;
+    static vector<EntityHandle> expiredEntities;
+    expiredEntities.clear();
+    QueryArchetypes(ComponentBit(COMPONENT_LIFETIME), lifetimeArchetypes);
+    for (Archetype* archetype : lifetimeArchetypes) {
+        LifetimeComponent* lifetimes = GetComponentColumn<LifetimeComponent>(*archetype, COMPONENT_LIFETIME);
+        for (size_t row = 0; row < archetype->entities.size(); row++) {
+            lifetimes[row].timer -= simTickDuration;
+            if (lifetimes[row].timer <= 0.0f) expiredEntities.push_back(archetype->entities[row]);
+        }
+    }
+    for (EntityHandle entity : expiredEntities) DestroyEntity(entity);
+}
+
+void DrawVisualEffects(const RenderSnapshot& snapshot) {
+    for (const auto& effect : snapshot.visualEffects) {
         if (!effect.active) continue;
         float alpha = effect.timer / effect.lifespan;
         float scale = 1.0f + (1.0f - alpha) * 0.5f;
@@ -399,8 +514,9 @@ void DrawVisualEffects() {
 }
 
 void UpdateWeatherParticles() {
+    TraceScope trace("UpdateWeatherParticles");
     float dt = GetFrameTime();
-    if (currentDifficulty == MEDIUM) {
+    if (currentWeather == RAIN) {
         if (GetRandomValue(0, 100) < 40) {
             WeatherParticle p;
             p.position = { (float)GetRandomValue(-50, screenWidth + 50), (float)GetRandomValue(-60, -5) };
@@ -418,7 +534,7 @@ void UpdateWeatherParticles() {
             p.isSplash = false;
             weatherParticles.push_back(p);
         }
-    } else if (currentDifficulty == HARD) {
+    } else if (currentWeather == SNOW) {
         if (GetRandomValue(0, 100) < 25) {
             WeatherParticle p;
             p.position = { (float)GetRandomValue(-30, screenWidth + 30), (float)GetRandomValue(-50, -5) };
@@ -433,7 +549,7 @@ void UpdateWeatherParticles() {
         }
     }
     for (auto& p : weatherParticles) {
-        if (currentDifficulty == MEDIUM) {
+        if (currentWeather == RAIN) {
             if (!p.isSplash) {
                 p.velocity.y += 10.0f * dt;
                 p.position = Vector2Add(p.position, Vector2Scale(p.velocity, dt));
@@ -458,7 +574,7 @@ void UpdateWeatherParticles() {
             } else {
                 p.lifetime -= dt;
             }
-        } else if (currentDifficulty == HARD) {
+        } else if (currentWeather == SNOW) {
             p.wobble += p.wobbleSpeed * dt;
             if (p.wobble > 2 * PI) p.wobble -= 2 * PI;
             float wobbleOffset = sinf(p.wobble) * 0.7f;
@@ -484,7 +600,7 @@ void UpdateWeatherParticles() {
 
 void DrawWeatherParticles() {
     for (const auto& p : weatherParticles) {
-        if (currentDifficulty == MEDIUM) {
+        if (currentWeather == RAIN) {
             if (!p.isSplash) {
                 Vector2 endPoint = { p.position.x + p.velocity.x * 0.03f, p.position.y + p.velocity.y * 0.03f };
                 float length = Vector2Length(p.velocity) * 0.05f;
@@ -511,7 +627,7 @@ void DrawWeatherParticles() {
                     }
                 }
             }
-        } else if (currentDifficulty == HARD) {
+        } else if (currentWeather == SNOW) {
             Color snowColor = ColorAlpha(WHITE, p.alpha);
             DrawCircleV(p.position, p.size, snowColor);
             float innerSize = p.size * 0.6f;
@@ -531,20 +647,8 @@ void DrawWeatherParticles() {
     }
 }
 
-void UpdateTowerMalfunctions() {
-    if (currentDifficulty != HARD) return;
-    float now = GetTime();
-    for (auto& tower : towers) {
-        if (tower.type == NONE) continue;
-        if (!tower.isMalfunctioning && (now - tower.lastFiredTime) >= 30.0f) {
-            tower.isMalfunctioning = true;
-            tower.color = GRAY;
-        }
-    }
-}
-
 void DrawRainyAtmosphereOverlay() {
-    if (currentDifficulty == MEDIUM) {
+    if (currentWeather == RAIN) {
         DrawRectangle(0, 0, screenWidth, screenHeight, ColorAlpha(DARKBLUE, 0.07f));
         for (int i = 0; i < 5; i++) {
             float yPos = i * 20.0f - 50.0f;
@@ -554,14 +658,165 @@ void DrawRainyAtmosphereOverlay() {
     }
 }
 
-Texture2D CreateFallbackTexture(Color color) {
-    Image img = GenImageColor(64, 64, color);
-    Texture2D texture = LoadTextureFromImage(img);
-    UnloadImage(img);
-    return texture;
+void StepSimulation() {
+    TraceScope trace("StepSimulation");
+    UpdateGameElements();
+    SetAllocationTag(ALLOC_WAVES);
+    if (!waveInProgress && HasWave(currentWaveIndex)) {
+        waveDelay -= simTickDuration;
+        if (waveDelay <= 0.0f) {
+            waveInProgress = true;
+            StartWave(currentWaveIndex);
+        }
+    }
+    if (waveInProgress) {
+        SpawnDueEnemies();
+        if (spawnedEnemies >= currentTimeline.totalCount && enemies.empty()) {
+            waveInProgress = false;
+            RecordWaveEnd(currentWaveIndex);
+            currentWaveIndex++;
+            if (!HasWave(currentWaveIndex)) currentState = WIN;
+            else waveDelay = 15.0f;
+        }
+    }
+    SetAllocationTag(ALLOC_OTHER);
+    simTime += simTickDuration;
+}
+
+int GetSpeedMultiplier(SimSpeed speed) {
+    switch (speed) {
+        case SPEED_2X: return 2;
+        case SPEED_4X: return 4;
+        case SPEED_16X: return 16;
+        default: return 1;
+    }
+}
+
+const char* GetSpeedLabel(SimSpeed speed) {
+    switch (speed) {
+        case SPEED_1X: return "1x";
+        case SPEED_2X: return "2x";
+        case SPEED_4X: return "4x";
+        case SPEED_16X: return "16x";
+        case SPEED_MAX: return "MAX";
+        default: return "?";
+    }
+}
+
+void RunSimulationTicks() {
+    // Fixed-step sim decoupled from rendering: the frame's real time (scaled by the speed
+    // multiplier) is banked and paid out in whole ticks. Time that does not fit in the
+    // per-frame budget is dropped so a slow frame never snowballs into a slower one.
+    double frameStart = GetTime();
+    if (currentSimSpeed == SPEED_MAX) {
+        do {
+            StepSimulation();
+        } while (currentState == PLAYING && GetTime() - frameStart < maxSpeedFrameBudget);
+        simAccumulator = 0.0f;
+        return;
+    }
+    simAccumulator += GetFrameTime() * GetSpeedMultiplier(currentSimSpeed);
+    int ticks = 0;
+    while (simAccumulator >= simTickDuration && currentState == PLAYING) {
+        StepSimulation();
+        simAccumulator -= simTickDuration;
+        ticks++;
+        if (ticks >= maxTicksPerFrame || GetTime() - frameStart >= maxSpeedFrameBudget) {
+            simAccumulator = 0.0f;
+            break;
+        }
+    }
+}
+
+void DrawSpeedButton() {
+    DrawRectangleRec(speedButton, currentSimSpeed == SPEED_1X ? DARKGRAY : ORANGE);
+    DrawRectangleLinesEx(speedButton, 2.0f, WHITE);
+    const char* label = GetSpeedLabel(currentSimSpeed);
+    DrawText(label, speedButton.x + (speedButton.width - MeasureText(label, 18)) / 2, speedButton.y + 4, 18, WHITE);
+}
+
+void HandleSpeedButton() {
+    bool clicked = IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(GetMousePosition(), speedButton);
+    if (clicked || IsKeyPressed(KEY_F)) {
+        currentSimSpeed = (SimSpeed)((currentSimSpeed + 1) % SIM_SPEED_COUNT);
+        simAccumulator = 0.0f;
+    }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    SetTraceThreadName("Main");
+    const char* telemetryPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        // --grid <columns>x<rows> plays the built-in layouts on a larger board
+        int columns = 0, rows = 0;
+        if (string(argv[i]) == "--compile-map" && i + 2 < argc) {
+            // Offline step: turn a text map into the memory-mappable binary form
+            return CompileMapFile(argv[i + 1], argv[i + 2]) ? 0 : 1;
+        }
+        if (string(argv[i]) == "--pack-assets" && i + 2 < argc) {
+            // Offline step: pack the listed PNGs into one file that is memory-mapped at startup
+            return PackAssetFiles(argv[i + 1], vector<string>(argv + i + 2, argv + argc)) ? 0 : 1;
+        }
+        if (string(argv[i]) == "--bench-kernels") {
+            // Verifies the SIMD geometry kernels against the scalar one and prints timings
+            return RunGeometryKernelBenchmark();
+        }
+        int instanceCount = 0;
+        if (string(argv[i]) == "--bench-envs" && i + 1 < argc && sscanf(argv[i + 1], "%d", &instanceCount) == 1 && instanceCount > 0) {
+            // Steps a batch of agent environments with random placement bots and prints ticks per second
+            return RunEnvironmentBenchmark(instanceCount);
+        }
+        if (string(argv[i]) == "--bench-paths") {
+            // Compares hierarchical paths with flat BFS on large random maps
+            return RunPathBenchmark();
+        }
+        if (string(argv[i]) == "--endless") {
+            // Procedural waves after the authored ones; an optional number picks the seed
+            endlessMode = true;
+            if (i + 1 < argc && sscanf(argv[i + 1], "%u", &endlessSeed) == 1) i++;
+            continue;
+        }
+        float targetMilliseconds = 0.0f;
+        if (string(argv[i]) == "--frame-target" && i + 1 < argc && sscanf(argv[i + 1], "%f", &targetMilliseconds) == 1 && targetMilliseconds > 0.0f) {
+            // Milliseconds of frame work the swarm level of detail tries to stay under
+            frameTimeTarget = targetMilliseconds / 1000.0f;
+            i++;
+            continue;
+        }
+        if (string(argv[i]) == "--alloc-assert") {
+            // Exit with status 1 if any frame after warm-up allocates; needs a make track build
+            allocationAssertEnabled = true;
+            continue;
+        }
+        if (string(argv[i]) == "--telemetry" && i + 1 < argc) {
+            // Per-tower, per-wave combat counters appended to a CSV file as each wave ends
+            telemetryPath = argv[++i];
+            continue;
+        }
+        if (string(argv[i]) == "--trace" && i + 1 < argc) {
+            // Capture a trace timeline from launch and write it to the file on exit (F4 also works)
+            SetTraceOutputPath(argv[++i]);
+            StartTraceCapture();
+            continue;
+        }
+        if (string(argv[i]) == "--no-separation") {
+            enemySeparationEnabled = false;
+            continue;
+        }
+        if (string(argv[i]) == "--map" && i + 1 < argc) {
+            customMapPath = argv[++i];
+            continue;
+        }
+        if (string(argv[i]) == "--grid" && i + 1 < argc && sscanf(argv[i + 1], "%dx%d", &columns, &rows) == 2 &&
+            columns >= defaultGridColumns && rows >= defaultGridRows) {
+            builtinMapColumns = columns;
+            builtinMapRows = rows;
+            i++;
+        }
+    }
+    // Started only once the game is really going to run: the offline and benchmark modes above
+    // return straight from main, and the environment workers they fork must not inherit the writer
+    if (telemetryPath != nullptr) StartTelemetry(telemetryPath);
     InitWindow(screenWidth, screenHeight, "Robust Tower Defense - v0.2");
     SetTargetFPS(60);
 
@@ -570,207 +825,131 @@ int main() {
     Texture2D hardmapgridTexture;
     Texture2D hardmaprightmostTexture;
 
-    tier1TowerTexture = LoadTexture("tier1tower.png");
-    if (tier1TowerTexture.id == 0) tier1TowerTexture = CreateFallbackTexture(BLUE);
-    tier2TowerTexture = LoadTexture("tier2tower.png");
-    if (tier2TowerTexture.id == 0) tier2TowerTexture = CreateFallbackTexture(GREEN);
-    tier3TowerTexture = LoadTexture("tier3tower.png");
-    if (tier3TowerTexture.id == 0) tier3TowerTexture = CreateFallbackTexture(RED);
-    placeholderTexture = LoadTexture("placeholder.png");
-    if (placeholderTexture.id == 0) placeholderTexture = CreateFallbackTexture(WHITE);
-    tier1ProjectileTexture = LoadTexture("tier1projectile.png");
-    if (tier1ProjectileTexture.id == 0) tier1ProjectileTexture = CreateFallbackTexture(SKYBLUE);
-    tier2ProjectileTexture = LoadTexture("tier2projectile.png");
-    if (tier2ProjectileTexture.id == 0) tier2ProjectileTexture = CreateFallbackTexture(LIME);
-    tier3ProjectileTexture = LoadTexture("tier3projectile.png");
-    if (tier3ProjectileTexture.id == 0) tier3ProjectileTexture = CreateFallbackTexture(ORANGE);
-    tier1EnemyTexture = LoadTexture("tier1enemy.png");
-    if (tier1EnemyTexture.id == 0) tier1EnemyTexture = CreateFallbackTexture(RED);
-    tier2EnemyTexture = LoadTexture("tier2enemy.png");
-    if (tier2EnemyTexture.id == 0) tier2EnemyTexture = CreateFallbackTexture(YELLOW);
-    backgroundTexture = LoadTexture("towerdefensegrass.png");
-    if (backgroundTexture.id == 0) backgroundTexture = CreateFallbackTexture(DARKGREEN);
-    tier3EnemyTexture = LoadTexture("tier3enemy.png");
-    if (tier3EnemyTexture.id == 0) tier3EnemyTexture = CreateFallbackTexture(DARKGRAY);
-    tier4EnemyTexture = LoadTexture("tier4enemy.png");
-    if (tier4EnemyTexture.id == 0) tier4EnemyTexture = CreateFallbackTexture(GOLD);
-    bottomGridTexture = LoadTexture("bottomsidegrid.png");
-    if (bottomGridTexture.id == 0) bottomGridTexture = CreateFallbackTexture(BROWN);
-    leftGridTexture = LoadTexture("leftsidegrid.png");
-    if (leftGridTexture.id == 0) leftGridTexture = CreateFallbackTexture(DARKBLUE);
-    topGridTexture = LoadTexture("topsidegrid.png");
-    if (topGridTexture.id == 0) topGridTexture = CreateFallbackTexture(PURPLE);
-    secondRightmostTexture = LoadTexture("secondrightmost.png");
-    if (secondRightmostTexture.id == 0) secondRightmostTexture = CreateFallbackTexture(GRAY);
-    rightGridTexture = LoadTexture("rightsidegrid.png");
-    if (rightGridTexture.id == 0) rightGridTexture = CreateFallbackTexture(MAROON);
-    mediummaptopTexture = LoadTexture("mediummaptop.png");
-    if (mediummaptopTexture.id == 0) mediummaptopTexture = CreateFallbackTexture(PURPLE);
-    mediummapgridTexture = LoadTexture("mediummapgrid.png");
-    if (mediummapgridTexture.id == 0) mediummapgridTexture = CreateFallbackTexture(DARKGREEN);
-    hardmapgridTexture = LoadTexture("hardmapgrid.png");
-    if (hardmapgridTexture.id == 0) hardmapgridTexture = CreateFallbackTexture(DARKGRAY);
-    hardmaprightmostTexture = LoadTexture("hardmaprightmost.png");
-    if (hardmaprightmostTexture.id == 0) hardmaprightmostTexture = CreateFallbackTexture(MAROON);
+    OpenAssetPack();
+    QueueTextureLoad("tier1tower.png", &tier1TowerTexture, BLUE);
+    QueueTextureLoad("tier2tower.png", &tier2TowerTexture, GREEN);
+    QueueTextureLoad("tier3tower.png", &tier3TowerTexture, RED);
+    QueueTextureLoad("tier1projectile.png", &tier1ProjectileTexture, SKYBLUE);
+    QueueTextureLoad("tier2projectile.png", &tier2ProjectileTexture, LIME);
+    QueueTextureLoad("tier3projectile.png", &tier3ProjectileTexture, ORANGE);
+    QueueTextureLoad("tier1enemy.png", &tier1EnemyTexture, RED);
+    QueueTextureLoad("tier2enemy.png", &tier2EnemyTexture, YELLOW);
+    QueueTextureLoad("towerdefensegrass.png", &backgroundTexture, DARKGREEN);
+    QueueTextureLoad("tier3enemy.png", &tier3EnemyTexture, DARKGRAY);
+    QueueTextureLoad("tier4enemy.png", &tier4EnemyTexture, GOLD);
+    QueueTextureLoad("bottomsidegrid.png", &bottomGridTexture, BROWN);
+    QueueTextureLoad("leftsidegrid.png", &leftGridTexture, DARKBLUE);
+    QueueTextureLoad("topsidegrid.png", &topGridTexture, PURPLE);
+    QueueTextureLoad("secondrightmost.png", &secondRightmostTexture, GRAY);
+    QueueTextureLoad("rightsidegrid.png", &rightGridTexture, MAROON);
+    QueueTextureLoad("mediummaptop.png", &mediummaptopTexture, PURPLE);
+    QueueTextureLoad("mediummapgrid.png", &mediummapgridTexture, DARKGREEN);
+    QueueTextureLoad("hardmapgrid.png", &hardmapgridTexture, DARKGRAY);
+    QueueTextureLoad("hardmaprightmost.png", &hardmaprightmostTexture, MAROON);
+    StartAssetDecoding();
+    Texture2D* tileArtTextures[TILE_ART_COUNT] = {
+        &backgroundTexture, &leftGridTexture, &rightGridTexture, &secondRightmostTexture, &topGridTexture,
+        &bottomGridTexture, &mediummapgridTexture, &mediummaptopTexture, &hardmapgridTexture, &hardmaprightmostTexture
+    };
 
     InitGrid();
+    NotifyGridChanged();
     InitWaypoints();
 
+    int exitCode = 0;
     while (!WindowShouldClose()) {
+        // Captures start and stop between frames, when the sim thread is idle
+        HandleTraceCapture();
+        BeginTraceScope("Frame");
+        double frameStart = GetTime();
+        double simWaitTime = 0.0;
+        BeginAllocationFrame();
+        BeginTraceScope("Input");
+        UploadDecodedAssets();
         if (IsKeyPressed(KEY_P)) {
             currentState = PLAYING;
             ResetGame();
         }
         if (currentState == PLAYING || currentState == PAUSED) {
+            UpdateMapCamera();
             HandlePauseButton();
             if (currentState == PLAYING) {
                 HandleSkipWaveButton();
                 HandleTowerMenuClick();
                 HandleTowerSelection();
                 HandleTowerPlacement();
-                UpdateGameElements();
-                if (!waveInProgress && currentWaveIndex < waves.size()) {
-                    waveDelay -= GetFrameTime();
-                    if (waveDelay <= 0.0f) {
-                        waveInProgress = true;
-                        waveTimer = 0.0f;
-                        spawnedEnemies = 0;
-                        defeatedEnemies = 0;
-                    }
-                }
-                if (waveInProgress) {
-                    waveTimer -= GetFrameTime();
-                    int totalEnemies = waves[currentWaveIndex].basicCount + waves[currentWaveIndex].fastCount +
-                                       waves[currentWaveIndex].armouredCount + waves[currentWaveIndex].fastArmouredCount;
-                    if (waveTimer <= 0.0f && spawnedEnemies < totalEnemies) {
-                        EnemyType type;
-                        if (spawnedEnemies < waves[currentWaveIndex].basicCount) type = BASIC_ENEMY;
-                        else if (spawnedEnemies < waves[currentWaveIndex].basicCount + waves[currentWaveIndex].fastCount) type = FAST_ENEMY;
-                        else if (spawnedEnemies < waves[currentWaveIndex].basicCount + waves[currentWaveIndex].fastCount + waves[currentWaveIndex].armouredCount) type = ARMOURED_ENEMY;
-                        else type = FAST_ARMOURED_ENEMY;
-                        // Use center-left spawn point (i.e. column 0, row = gridRows/2)
-                        Vector2 spawnPoint = { tileWidth / 2.0f, (float)(gridRows * tileHeight) / 2.0f };
-                        enemies.push_back(CreateEnemy(type, spawnPoint));
-                        waveTimer = waves[currentWaveIndex].spawnInterval;
-                        spawnedEnemies++;
-                        Enemy &e = enemies.back();
-                        if (currentDifficulty == MEDIUM) {
-                            e.maxHp = (int)(e.maxHp * 1.2f);
-                            e.hp = e.maxHp;
-                        } else if (currentDifficulty == HARD) {
-                            e.maxHp = (int)(e.maxHp * 1.4f);
-                            e.hp = e.maxHp;
-                        }
-                    }
-                    if (spawnedEnemies >= totalEnemies && enemies.empty()) {
-                        waveInProgress = false;
-                        currentWaveIndex++;
-                        if (currentWaveIndex >= waves.size()) currentState = WIN;
-                        else waveDelay = 15.0f;
-                    }
-                }
-                for (auto& tower : towers) {
-                    tower.rotationAngle += tower.rotationSpeed * GetFrameTime();
-                    if (tower.rotationAngle > 360.0f) tower.rotationAngle -= 360.0f;
-                }
+                HandleSpeedButton();
+                HandleCoverageHeatmapToggle();
                 UpdateWeatherParticles();
-                if (currentDifficulty == HARD) UpdateTowerMalfunctions();
             }
+            HandleSelectedTowerPanel();
         }
+        // The route check searches the path hierarchy the sim thread also uses, so it runs now
+        Vector2Int ghostTile = GetGridCoords(GetMouseWorldPosition());
+        bool ghostBlocksRoute = currentState == PLAYING && selectedTowerType != NONE && WouldBlockRoute(ghostTile);
+        // From here until FinishSimulationFrame the sim thread owns game state; the world is drawn
+        // from the last snapshot meanwhile
+        GameState frameState = currentState;
+        EndTraceScope();
+        if (frameState == PLAYING) StartSimulationFrame();
 
         BeginDrawing();
         ClearBackground(BLACK);
+        SetAllocationTag(ALLOC_DRAW);
 
-        if (currentState == MENU) {
+        if (frameState == MENU) {
             DrawMenuScreen();
-        } else if (currentState == PLAYING || currentState == PAUSED) {
-            for (int row = 0; row < gridRows; row++) {
-                for (int col = 0; col < gridColumns; col++) {
-                    // Select sourceRec dimensions based on chosen difficulty texture
-                    Rectangle sourceRec = { 
-                        0.0f, 0.0f, 
-                        (float)(currentDifficulty == EASY ? backgroundTexture.width : 
-                        (currentDifficulty == MEDIUM ? mediummapgridTexture.width : hardmapgridTexture.width)), 
-                        (float)(currentDifficulty == EASY ? backgroundTexture.height : 
-                        (currentDifficulty == MEDIUM ? mediummapgridTexture.height : hardmapgridTexture.height))
-                    };
+        } else if (frameState == PLAYING || frameState == PAUSED) {
+            const RenderSnapshot& snapshot = GetRenderSnapshot();
+            BeginTraceScope("DrawWorld");
+            BeginMode2D(camera);
+            int minCol, maxCol, minRow, maxRow;
+            GetVisibleTileRange(minCol, maxCol, minRow, maxRow);
+            for (int row = minRow; row <= maxRow; row++) {
+                for (int col = minCol; col <= maxCol; col++) {
+                    const Texture2D& tileTexture = *tileArtTextures[GetTileArt(col, row)];
+                    Rectangle sourceRec = { 0.0f, 0.0f, (float)tileTexture.width, (float)tileTexture.height };
                     Rectangle destRec = { (float)(col * tileWidth), (float)(row * tileHeight), (float)tileWidth, (float)tileHeight };
-                    Vector2 origin = { 0.0f, 0.0f };
-                    Texture2D* textureToUse = nullptr;
-                    if (currentDifficulty == EASY) {
-                        textureToUse = &backgroundTexture;
-                        if (col == 0) textureToUse = &leftGridTexture;
-                        else if (col == gridColumns - 1) textureToUse = &rightGridTexture;
-                        else if (col == gridColumns - 2) textureToUse = &secondRightmostTexture;
-                        else if (row == 0) textureToUse = &topGridTexture;
-                        else if (row == gridRows - 1) textureToUse = &bottomGridTexture;
-                    } else if (currentDifficulty == MEDIUM) {
-                        textureToUse = &mediummapgridTexture;
-                        if (col == 0) textureToUse = &mediummaptopTexture;
-                    } else if (currentDifficulty == HARD) {
-                        textureToUse = &hardmapgridTexture;
-                        if (col == gridColumns - 1) textureToUse = &hardmaprightmostTexture;
-                    }
-                    DrawTexturePro(*textureToUse, sourceRec, destRec, origin, 0.0f, WHITE);
+                    DrawTexturePro(tileTexture, sourceRec, destRec, { 0.0f, 0.0f }, 0.0f, WHITE);
                 }
             }
             for (size_t i = 0; i < waypoints.size() - 1; ++i) {
                 DrawLineV(waypoints[i], waypoints[i + 1], ColorAlpha(LIGHTGRAY, 0.5f));
             }
+            DrawCoverageHeatmap(snapshot);
             DrawGridHighlight();
             if (selectedTowerType != NONE) {
-                Vector2 mousePos = GetMousePosition();
-                int gridCol = mousePos.x / tileWidth;
-                int gridRow = mousePos.y / tileHeight;
-                if (gridCol >= 0 && gridCol < gridColumns && gridRow >= 0 && gridRow < gridRows && grid[gridRow][gridCol]) {
+                int gridCol = ghostTile.x;
+                int gridRow = ghostTile.y;
+                if (IsInsideGrid(gridCol, gridRow) && IsTileWalkable(gridCol, gridRow)) {
                     Tower ghostTower = CreateTower(NONE, { (float)(gridCol * tileWidth + tileWidth / 2), (float)(gridRow * tileHeight + tileHeight / 2) });
-                    DrawCircleV(ghostTower.position, tileWidth / 2.5f, ghostTower.color);
+                    if (ghostBlocksRoute) {
+                        // Placing here would seal off the only route to the goal
+                        DrawCircleV(ghostTower.position, tileWidth / 2.5f, ColorAlpha(RED, 0.5f));
+                        DrawLineEx({ ghostTower.position.x - 10, ghostTower.position.y - 10 }, { ghostTower.position.x + 10, ghostTower.position.y + 10 }, 3.0f, RED);
+                        DrawLineEx({ ghostTower.position.x - 10, ghostTower.position.y + 10 }, { ghostTower.position.x + 10, ghostTower.position.y - 10 }, 3.0f, RED);
+                    } else {
+                        DrawCircleV(ghostTower.position, tileWidth / 2.5f, ghostTower.color);
+                    }
                 }
             }
-            DrawGameElements();
+            DrawGameElements(snapshot);
+            EndMode2D();
             DrawRainyAtmosphereOverlay();
-            if (currentDifficulty == MEDIUM || currentDifficulty == HARD) DrawWeatherParticles();
-            DrawText("Tower Defense", titleX - MeasureText("Tower Defense", 20) / 2, titleY, 20, MAROON);
-            DrawText(TextFormat("Money: %d", playerMoney), moneyX, moneyY, regularTextFontSize, textColor);
-            DrawText(TextFormat("Escaped: %d/%d", enemiesReachedEnd, maxEnemiesReachedEnd), escapedX, escapedY, regularTextFontSize, RED);
-            if (waveInProgress) {
-                int totalEnemies = waves[currentWaveIndex].basicCount + waves[currentWaveIndex].fastCount + waves[currentWaveIndex].armouredCount + waves[currentWaveIndex].fastArmouredCount;
-                int enemiesRemaining = totalEnemies - spawnedEnemies + (int)enemies.size();
-                DrawText(TextFormat("Wave %d - Enemies Remaining: %d", currentWaveIndex + 1, enemiesRemaining), waveInfoX, waveInfoY, regularTextFontSize, textColor);
-            } else if (currentWaveIndex < waves.size()) {
-                string nextWaveText = "Next Wave in " + to_string((int)waveDelay + 1);
-                DrawText(nextWaveText.c_str(), screenWidth / 2 - MeasureText(nextWaveText.c_str(), largeTextFontSize) / 2, nextWaveTimerY, largeTextFontSize, BLUE);
-            } else {
-                DrawText("All Waves Completed!", waveInfoX, waveInfoY, regularTextFontSize, GREEN);
-            }
-            int currentMenuX = towerMenuStartX;
-            Rectangle tier1Rec = { (float)currentMenuX, (float)towerMenuStartY, (float)towerSelectionWidth, (float)towerSelectionHeight };
-            DrawRectangleRec(tier1Rec, BLUE);
-            DrawRectangleLinesEx(tier1Rec, 2.0f, selectedTowerType == TIER1_DEFAULT ? GOLD : DARKGRAY);
-            DrawText(GetTowerName(TIER1_DEFAULT), currentMenuX + 10, towerMenuStartY + 10, towerTypeTextSize, WHITE);
-            DrawText(TextFormat("$%d", GetTowerCost(TIER1_DEFAULT)), currentMenuX + 10, towerMenuStartY + towerSelectionHeight - 25, regularTextFontSize, WHITE);
-            currentMenuX += towerMenuSpacingX;
-            Rectangle tier2Rec = { (float)currentMenuX, (float)towerMenuStartY, (float)towerSelectionWidth, (float)towerSelectionHeight };
-            DrawRectangleRec(tier2Rec, GREEN);
-            DrawRectangleLinesEx(tier2Rec, 2.0f, selectedTowerType == TIER2_FAST ? GOLD : DARKGRAY);
-            DrawText(GetTowerName(TIER2_FAST), currentMenuX + 10, towerMenuStartY + 10, towerTypeTextSize, WHITE);
-            DrawText(TextFormat("$%d", GetTowerCost(TIER2_FAST)), currentMenuX + 10, towerMenuStartY + towerSelectionHeight - 25, regularTextFontSize, WHITE);
-            currentMenuX += towerMenuSpacingX;
-            Rectangle tier3Rec = { (float)currentMenuX, (float)towerMenuStartY, (float)towerSelectionWidth, (float)towerSelectionHeight };
-            DrawRectangleRec(tier3Rec, RED);
-            DrawRectangleLinesEx(tier3Rec, 2.0f, selectedTowerType == TIER3_STRONG ? GOLD : DARKGRAY);
-            DrawText(GetTowerName(TIER3_STRONG), currentMenuX + 10, towerMenuStartY + 10, towerTypeTextSize, WHITE);
-            DrawText(TextFormat("$%d", GetTowerCost(TIER3_STRONG)), currentMenuX + 10, towerMenuStartY + towerSelectionHeight - 25, regularTextFontSize, WHITE);
-            if (selectedTowerType != NONE) {
-                DrawText(TextFormat("Selected: %s", GetTowerName(selectedTowerType)), uiPadding, selectedTowerTextY, regularTextFontSize, GOLD);
-            }
-            DrawSelectedTowerInfo();
-            DrawWaveProgressBar();
+            if (currentWeather != WEATHER_NONE) DrawWeatherParticles();
+            EndTraceScope();
+            // The sim runs alongside the draw; time spent waiting on it is not drawing cost
+            double simWaitStart = GetTime();
+            FinishSimulationFrame();
+            simWaitTime = GetTime() - simWaitStart;
+            SetAllocationTag(ALLOC_HUD);
+            DrawCachedHud();
             DrawTowerTooltip(TIER1_DEFAULT, GetMousePosition()); // Simplified; actual logic in tower.cpp
             DrawPauseButton();
+            DrawSpeedButton();
             DrawSkipWaveButton();
             if (currentState == PAUSED) DrawPauseScreen();
-        } else if (currentState == GAME_OVER || currentState == WIN) {
+        } else if (frameState == GAME_OVER || frameState == WIN) {
             for (int y = 0; y < screenHeight; y += backgroundTexture.height) {
                 for (int x = 0; x < screenWidth; x += backgroundTexture.width) {
                     Rectangle sourceRec = { 0.0f, 0.0f, (float)backgroundTexture.width, (float)backgroundTexture.height };
@@ -798,30 +977,25 @@ int main() {
                 currentState = MENU;
             }
         }
+        DrawAllocationOverlay();
+        lastFrameWorkTime = GetTime() - frameStart - simWaitTime;
+        BeginTraceScope("EndDrawing");
         EndDrawing();
+        EndTraceScope();
+        ReportFirstFrame();
+        EndTraceScope();
+        SetAllocationTag(ALLOC_OTHER);
+        if (!EndAllocationFrame()) {
+            exitCode = 1;
+            break;
+        }
     }
 
-    UnloadTexture(tier1TowerTexture);
-    UnloadTexture(tier2TowerTexture);
-    UnloadTexture(tier3TowerTexture);
-    UnloadTexture(placeholderTexture);
-    UnloadTexture(tier1ProjectileTexture);
-    UnloadTexture(tier2ProjectileTexture);
-    UnloadTexture(tier3ProjectileTexture);
-    UnloadTexture(tier1EnemyTexture);
-    UnloadTexture(tier2EnemyTexture);
-    UnloadTexture(backgroundTexture);
-    UnloadTexture(tier3EnemyTexture);
-    UnloadTexture(tier4EnemyTexture);
-    UnloadTexture(bottomGridTexture);
-    UnloadTexture(leftGridTexture);
-    UnloadTexture(topGridTexture);
-    UnloadTexture(secondRightmostTexture);
-    UnloadTexture(rightGridTexture);
-    UnloadTexture(mediummaptopTexture);
-    UnloadTexture(mediummapgridTexture);
-    UnloadTexture(hardmapgridTexture);
-    UnloadTexture(hardmaprightmostTexture);
+    StopSimulationThread();
+    StopTraceCapture();
+    StopTelemetry();
+    UnloadUiLayers();
+    UnloadAssets();
     CloseWindow();
-    return 0;
+    return exitCode;
 }
\ No newline at end of file
@@ -10,6 +10,8 @@
 #include <queue>
 #include <map>
 #include <filesystem>
+#include <cstdint>
+#include <memory>
 
 using namespace std;
 namespace fs = std::filesystem;
@@ -17,10 +19,20 @@ namespace fs = std::filesystem;
 // Constants
 const int screenWidth = 800;
 const int screenHeight = 600;
-const int gridColumns = 15;
-const int gridRows = 10;
-const int tileWidth = screenWidth / gridColumns;
-const int tileHeight = screenHeight / gridRows;
+const int defaultGridColumns = 15;
+const int defaultGridRows = 10;
+const int tileWidth = screenWidth / defaultGridColumns;
+const int tileHeight = screenHeight / defaultGridRows;
+const int gridChunkSize = 8; // Tiles per chunk side; a chunk's walkable flags fit one 64-bit mask
+const float cameraPanSpeed = 600.0f;
+const float minCameraZoom = 0.25f;
+const float maxCameraZoom = 2.0f;
+const char mapFileMagic[4] = { 'T', 'D', 'M', 'B' };
+const uint32_t mapFileVersion = 1;
+const int maxMapDimension = 4096;
+const char assetPackMagic[4] = { 'T', 'D', 'P', 'K' };
+const uint32_t assetPackVersion = 1;
+const char assetPackFileName[] = "assets.tdpak"; // Looked up next to the executable
 
 // UI constants
 const int uiPadding = 10;
@@ -55,6 +67,32 @@ const int progressBarHeight = 15;
 const int progressBarX = screenWidth - progressBarWidth - 20;
 const int progressBarY = 60;
 const int maxEnemiesReachedEnd = 10;
+const float flamethrowerSplashRadius = 50.0f;
+const int targetingButtonHeight = 22;
+const int tooltipWidth = 200;
+const int tooltipHeight = 150;
+const float simTickDuration = 1.0f / 60.0f;
+const int maxTicksPerFrame = 64;
+const double maxSpeedFrameBudget = 0.012; // Seconds of sim work allowed per rendered frame
+const float towerMalfunctionDelay = 30.0f; // HARD: towers idle this long break down
+const float separationRadius = 18.0f; // Enemies closer than this push each other apart
+const float maxSeparationOffset = 18.0f; // Furthest an enemy drifts from its route; stays inside the lane tile
+const float separationStrength = 40.0f; // Pixels per second of drift at full push
+const int maxSeparationNeighbors = 8;
+const int pathRequestStepBudget = 65536; // Search steps and delivered path tiles the path service may spend per tick
+const int pathClusterSize = 16; // Tiles per side of a hierarchical pathfinding cluster
+const int pathRefineTiles = 64; // Tiles of an enemy route refined per path request
+const int pathRefineMargin = 16; // Tiles left on a partial route when the next stretch is requested
+const int maxEndlessWaveEnemies = 250000;
+const int lodEnemyThreshold = 1500; // Visible enemies past which the swarm is always drawn clustered
+const int lodMinEnemies = 300; // Below this many visible enemies the swarm is never clustered
+const int allocationWarmupFrames = 300; // Frames --alloc-assert lets allocate before expecting none
+const float defaultFrameTimeTarget = 1.0f / 60.0f; // Seconds of frame work before clustering kicks in
+const int telemetryRingCapacity = 1 << 16; // Telemetry events buffered for the writer; a power of two
+const int telemetryWriterIntervalMs = 20; // How often the telemetry writer drains the ring
+const int traceMaxEventsPerThread = 1 << 20; // Trace scopes kept per thread in one capture
+const char traceFileName[] = "trace.json"; // Where F4 captures go unless --trace names a file
+const int envMaxActionsPerStep = 4096; // Actions one StepEnvironments call can carry across the batch
 
 // Structs and Enums
 struct Vector2Int {
@@ -62,6 +100,21 @@ struct Vector2Int {
     int y;
 };
 
+// Handle to an entity in the archetype storage; a zeroed handle never refers to a live entity
+struct EntityHandle {
+    uint32_t index;
+    uint32_t generation;
+};
+
+// Walkable flags stored as 8x8 tile chunks, so a tile and its neighbours usually share a
+// cache line regardless of map width
+struct TileGrid {
+    int columns;
+    int rows;
+    int chunkColumns;
+    vector<uint64_t> chunks;
+};
+
 enum TowerType {
     NONE,
     TIER1_DEFAULT,
@@ -70,28 +123,60 @@ enum TowerType {
     TOWER_TYPE_COUNT
 };
 
+// Where a tower's damage came from, for combat telemetry
+enum DamageSource {
+    DAMAGE_DIRECT,
+    DAMAGE_LASER,
+    DAMAGE_SPLASH,
+    DAMAGE_BURN,
+    DAMAGE_SOURCE_COUNT
+};
+
+enum TargetingPolicy {
+    TARGET_FIRST,
+    TARGET_STRONGEST,
+    TARGET_WEAKEST,
+    TARGET_CLOSEST,
+    TARGET_CLUSTERED,
+    TARGETING_POLICY_COUNT
+};
+
 struct Tower {
     Vector2 position;
     Color color;
     float range;
     float fireRate;
-    float fireCooldown;
+    double nextFireTime; // simTime at which the tower may fire again
     TowerType type;
     int damage;
     Texture2D texture;
-    float rotationAngle;
-    float rotationSpeed;
+    float rotationSpeed; // Degrees per second; the angle is derived from simTime when drawn
     Texture2D projectileTexture;
     int upgradeLevel;
-    float abilityCooldownTimer;
+    double abilityReadyTime; // simTime the ability comes off cooldown
     float abilityCooldownDuration;
     bool abilityActive;
     float abilityDuration;
-    float abilityTimer;
+    double abilityEndTime; // simTime an active ability wears off
     float originalFireRate;
     bool isPowerShotActive;
     float lastFiredTime;
     bool isMalfunctioning;
+    TargetingPolicy targetingPolicy;
+    int targetEnemyId; // Cached target, kept until it dies or leaves range
+    float progressWindowMin; // Remaining-distance band an enemy inside range can have
+    float progressWindowMax;
+    int progressWindowVersion; // gridVersion the band was computed for, -1 when stale
+    int coveredEnemyCount; // Enemies standing on tiles this tower covers; 0 means dormant
+    int awakeSlot; // Position in the awake tower list, -1 while dormant
+};
+
+// Polyline an enemy walks along. Segment i runs from points[i] to points[i + 1]; routes are
+// immutable once built so enemies spawned onto the same route share one copy
+struct PathRoute {
+    vector<Vector2> points;
+    vector<Vector2> directions;     // Unit direction per segment, zero for degenerate segments
+    vector<float> segmentStarts;    // Route distance where each segment begins, plus the total length
 };
 
 enum EnemyType {
@@ -103,6 +188,8 @@ enum EnemyType {
 };
 
 struct Enemy {
+    int id; // Increases with spawn order, so `enemies` stays sorted by id
+    int occupiedCell; // Tile counted in the coverage occupancy, -1 when not counted
     Vector2 position;
     float speed;
     bool active;
@@ -114,20 +201,21 @@ struct Enemy {
     vector<Vector2Int> waypointsPath;
     int pathIndex;
     float pathCheckTimer; // Add path check timer for each enemy
-    Enemy() : pathIndex(0), pathCheckTimer(0.0f) {}
+    bool pathRequested; // Waiting on the path service; keeps following the current path meanwhile
+    shared_ptr<const PathRoute> route; // Polyline through the centers of waypointsPath (or waypoints)
+    float routeDistance; // Distance travelled along route
+    int routeSegment; // Segment containing routeDistance; heads to waypointsPath[routeSegment]
+    Vector2 separationOffset; // Sideways displacement from the route built up by separation steering
+    EntityHandle statusEntity; // Carries the enemy's slowed/burning components, if any
+    Enemy() : pathIndex(0), pathCheckTimer(0.0f), routeDistance(0.0f), routeSegment(0), separationOffset{ 0.0f, 0.0f }, statusEntity{ 0, 0 } {}
     Texture2D texture;
     float originalSpeed;
-    float slowTimer;
-    bool isSlowed;
-    bool hasDotEffect;
-    float dotTimer;
-    float dotTickTimer;
-    int dotDamage;
 };
 
+// Describes a shot for SpawnProjectile; live projectiles are entities (ecs.cpp)
 struct Projectile {
     Vector2 position;
-    Enemy* targetEnemy;
+    int targetEnemyId;
     float speed;
     int damage;
     bool active;
@@ -135,6 +223,7 @@ struct Projectile {
     enum class Type { STANDARD, FLAMETHROWER } type;
     Vector2 sourcePosition;
     float effectRadius;
+    int sourceTower; // Index into towers, for telemetry
 };
 
 struct EnemyWave {
@@ -145,6 +234,18 @@ struct EnemyWave {
     float spawnInterval;
 };
 
+// A wave compiled for spawning: consecutive runs of one type, each ending at a spawn index
+struct SpawnRun {
+    EnemyType type;
+    int endIndex;
+};
+
+struct SpawnTimeline {
+    vector<SpawnRun> runs;
+    int totalCount;
+    float spawnInterval;
+};
+
 enum GameState {
     MENU,
     PLAYING,
@@ -172,8 +273,244 @@ struct LaserBeam {
     float thickness;
 };
 
+// Entity storage (ecs.cpp): entities grouped into archetypes by component set, one contiguous
+// column per component. Projectiles, effects and beams live here, as do enemy statuses attached
+// by enemy id.
+enum ComponentType {
+    COMPONENT_POSITION,      // Vector2
+    COMPONENT_LIFETIME,      // LifetimeComponent
+    COMPONENT_FADING_CIRCLE, // FadingCircleComponent
+    COMPONENT_BEAM,          // BeamComponent
+    COMPONENT_STATUS_TARGET, // int, id of the enemy the statuses apply to
+    COMPONENT_SLOWED,        // SlowedComponent
+    COMPONENT_BURNING,       // BurningComponent
+    COMPONENT_PROJECTILE,    // ProjectileComponent
+    COMPONENT_SPLASH,        // SplashComponent
+    COMPONENT_TYPE_COUNT
+};
+
+typedef uint32_t ComponentMask;
+
+struct Archetype {
+    ComponentMask mask;
+    vector<EntityHandle> entities; // Owner of each row
+    vector<uint8_t> columns[COMPONENT_TYPE_COUNT]; // Packed rows; empty for components not in mask
+};
+
+struct LifetimeComponent {
+    float lifespan;
+    float timer; // Entity is destroyed when this runs out
+};
+
+struct FadingCircleComponent {
+    Color color;
+    float radius;
+};
+
+struct BeamComponent {
+    Vector2 start;
+    Vector2 end;
+    Color color;
+    float thickness;
+};
+
+struct SlowedComponent {
+    float timer;
+};
+
+struct BurningComponent {
+    float timer;
+    float tickTimer;
+    int damage; // Per tick
+    int sourceTower;
+};
+
+struct ProjectileComponent {
+    int targetEnemyId;
+    float speed;
+    int damage;
+    Texture2D texture;
+    Vector2 sourcePosition;
+    int sourceTower; // Index into towers, for telemetry
+};
+
+// A projectile with splash damages and sets fire to everything around the impact, and leaves a
+// trail of flames in flight
+struct SplashComponent {
+    float radius;
+};
+
+// Render snapshot: everything the world draw reads from simulation state, copied by the sim thread
+// after its ticks and only read while drawing, so drawing never touches live game state
+struct TowerSprite {
+    Vector2 position;
+    Texture2D texture;
+    Color color;
+    float range;
+    float rotation;
+    int upgradeLevel;
+    float dps; // 0 while malfunctioning; feeds the coverage heatmap
+};
+
+struct EnemySprite {
+    Vector2 position;
+    Texture2D texture;
+    Color color;
+    float hpRatio;
+    shared_ptr<const PathRoute> route; // Null when following the default waypoints
+    int routeSegment;
+};
+
+struct ProjectileSprite {
+    Vector2 position;
+    Vector2 sourcePosition;
+    Texture2D texture;
+    Projectile::Type type;
+};
+
+struct RenderSnapshot {
+    vector<TowerSprite> towers;
+    vector<EnemySprite> enemies;
+    vector<ProjectileSprite> projectiles;
+    vector<VisualEffect> visualEffects;
+    vector<LaserBeam> laserBeams;
+};
+
+// Times the enclosing block into the current trace capture (trace.cpp)
+struct TraceScope {
+    TraceScope(const char* name);
+    ~TraceScope();
+};
+
+// Subsystem an allocation is charged to when built with TRACK_ALLOCATIONS
+enum AllocationTag {
+    ALLOC_OTHER,
+    ALLOC_PATHS,
+    ALLOC_ENEMIES,
+    ALLOC_TOWERS,
+    ALLOC_EFFECTS,
+    ALLOC_WAVES,
+    ALLOC_SNAPSHOT,
+    ALLOC_DRAW,
+    ALLOC_HUD,
+    ALLOC_TAG_COUNT
+};
+
+struct AllocationFrameStats {
+    uint64_t counts[ALLOC_TAG_COUNT];
+    uint64_t bytes[ALLOC_TAG_COUNT];
+    uint64_t totalCount;
+    uint64_t totalBytes;
+    int64_t liveBytes;
+    int64_t peakBytes; // Most bytes live at any point during the frame
+};
+
 enum MapDifficulty { EASY, MEDIUM, HARD };
 enum WeatherType { WEATHER_NONE, RAIN, SNOW };
+enum SimSpeed { SPEED_1X, SPEED_2X, SPEED_4X, SPEED_16X, SPEED_MAX, SIM_SPEED_COUNT };
+
+// Batched environments for automated agents (env.cpp)
+enum EnvActionType {
+    ENV_ACTION_PLACE_TOWER,
+    ENV_ACTION_UPGRADE_TOWER,     // Tower on tile
+    ENV_ACTION_ACTIVATE_ABILITY,  // Tower on tile
+    ENV_ACTION_RESET              // Start the instance's game over
+};
+
+struct EnvAction {
+    int instance;
+    EnvActionType type;
+    TowerType towerType; // Placement only
+    Vector2Int tile;
+};
+
+struct EnvBatchConfig {
+    int instanceCount;
+    MapDifficulty difficulty;
+    int columns; // Built-in layout size, at least the default grid
+    int rows;
+    bool endless;
+    uint32_t seed; // Endless seed of instance 0; instance i uses seed + i
+};
+
+struct EnvStatus {
+    int money;
+    int wave;
+    int aliveEnemies;
+    int enemiesEscaped;
+    int waveEnemiesDefeated;
+    int towerCount;
+    int rejectedActions; // Actions from the last step that could not be applied
+    GameState state;
+    double simTime;
+};
+
+// Per-tile layers hold instanceCount blocks of columns * rows entries, row-major; all buffers must
+// come from AllocateEnvironmentBuffer
+struct EnvObservation {
+    uint8_t* walkable;
+    uint8_t* towerType;  // TowerType, NONE when empty
+    uint8_t* towerLevel;
+    uint16_t* enemyCount; // Live enemies standing on the tile
+    EnvStatus* status;    // One per instance
+};
+
+enum TileArt {
+    TILE_ART_GRASS,
+    TILE_ART_LEFT_EDGE,
+    TILE_ART_RIGHT_EDGE,
+    TILE_ART_SECOND_RIGHTMOST,
+    TILE_ART_TOP_EDGE,
+    TILE_ART_BOTTOM_EDGE,
+    TILE_ART_MEDIUM_GRID,
+    TILE_ART_MEDIUM_TOP,
+    TILE_ART_HARD_GRID,
+    TILE_ART_HARD_RIGHTMOST,
+    TILE_ART_COUNT
+};
+
+// Binary map layout (.tdmb); offsets are from the start of the file
+struct MapFileHeader {
+    char magic[4];
+    uint32_t version;
+    int32_t columns;
+    int32_t rows;
+    int32_t spawnCol;
+    int32_t spawnRow;
+    int32_t goalCol;
+    int32_t goalRow;
+    int32_t weather;
+    int32_t chunkColumns;
+    int32_t chunkRows;
+    uint32_t walkableOffset; // uint64_t chunk masks in TileGrid order
+    uint32_t artOffset;      // one TileArt byte per tile, row-major
+    uint32_t fileSize;
+};
+
+// Packed textures (.tdpak): a header, then entryCount entries, then the PNG bytes; offsets are
+// from the start of the file
+struct AssetPackHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t fileSize;
+};
+
+struct AssetPackEntry {
+    char name[48]; // File name without directories, NUL terminated
+    uint32_t offset;
+    uint32_t size;
+};
+
+// A loaded map points into either a read-only file mapping or ownedData (built-in/text maps)
+struct GameMap {
+    const MapFileHeader* header;
+    const uint64_t* walkableChunks;
+    const uint8_t* tileArt;
+    void* mappedData;
+    size_t mappedSize;
+    vector<uint8_t> ownedData;
+};
 
 struct WeatherParticle {
     Vector2 position;
@@ -189,24 +526,35 @@ struct WeatherParticle {
 };
 
 // Global Variables (extern declarations)
-extern bool grid[gridRows][gridColumns];
+extern TileGrid grid;
+extern int gridColumns;
+extern int gridRows;
+extern Camera2D camera;
+extern GameMap currentMap;
+extern string customMapPath;
+extern int builtinMapColumns;
+extern int builtinMapRows;
 extern vector<Tower> towers;
+extern vector<int> towerAtTile; // Index into towers per tile (row-major), -1 when empty
 extern vector<Enemy> enemies;
-extern vector<Projectile> projectiles;
 extern vector<Vector2> waypoints;
 extern vector<EnemyWave> waves;
-extern vector<VisualEffect> visualEffects;
-extern vector<LaserBeam> laserBeams;
 extern vector<WeatherParticle> weatherParticles;
 extern int playerMoney;
 extern TowerType selectedTowerType;
 extern int currentWaveIndex;
-extern float waveTimer;
+extern double waveStartTime; // simTime the current wave started spawning
+extern SpawnTimeline currentTimeline;
+extern bool endlessMode;
+extern uint32_t endlessSeed;
 extern float waveDelay;
 extern bool waveInProgress;
 extern int spawnedEnemies;
 extern int defeatedEnemies;
 extern int enemiesReachedEnd;
+extern int nextEnemyId;
+extern int gridVersion;
+extern vector<int> goalDistanceField;
 extern GameState currentState;
 extern int selectedTowerIndex;
 extern MapDifficulty currentDifficulty;
@@ -214,7 +562,6 @@ extern WeatherType currentWeather;
 extern Texture2D tier1TowerTexture;
 extern Texture2D tier2TowerTexture;
 extern Texture2D tier3TowerTexture;
-extern Texture2D placeholderTexture;
 extern Texture2D tier1ProjectileTexture;
 extern Texture2D tier2ProjectileTexture;
 extern Texture2D tier3ProjectileTexture;
@@ -232,51 +579,273 @@ extern Rectangle pauseButton;
 extern bool isPaused;
 extern Rectangle skipWaveButton;
 extern bool showSkipButton;
+extern Rectangle speedButton;
+extern SimSpeed currentSimSpeed;
+extern double simTime;
+extern float simAccumulator;
+extern bool showCoverageHeatmap;
+extern bool enemySeparationEnabled;
+extern bool enemyLodActive;
+extern bool allocationAssertEnabled;
+extern float frameTimeTarget;
+extern double lastFrameWorkTime;
 
 // Function Prototypes
 void InitGrid();
+void InitTileGrid(int columns, int rows);
+void SetTileWalkable(int col, int row, bool walkable);
+vector<Vector2Int> FindPathToGoal(Vector2Int start);
+Vector2 GetMouseWorldPosition();
+void UpdateMapCamera();
+void GetVisibleTileRange(int& minCol, int& maxCol, int& minRow, int& maxRow);
 void InitWaypoints();
+Vector2 GetSpawnPoint();
 Vector2Int GetGridCoords(Vector2 position);
 Vector2 GetTileCenter(Vector2Int gridCoords);
 vector<Vector2Int> FindPathBFS(Vector2Int start, Vector2Int end);
+void BuildGoalDistanceField();
+void RepairGoalDistanceField(Vector2Int blockedTile);
+int GetGoalDistance(Vector2Int gridCoords);
+void NotifyGridChanged();
+void NotifyTileBlocked(Vector2Int gridCoords);
 void DrawPath(const vector<Vector2Int>& path, Color color);
 Tower CreateTower(TowerType type, Vector2 position);
 int GetTowerCost(TowerType type);
 const char* GetTowerName(TowerType type);
 int GetTowerUpgradeCost(TowerType type, int currentLevel);
 void ApplyTowerUpgrade(Tower& tower);
+void RebuildTowerTileIndex();
+int GetTowerAtTile(Vector2Int gridCoords);
+float GetTowerDps(const Tower& tower);
+bool PlaceTower(TowerType type, Vector2Int tile);
 void HandleTowerPlacement();
 bool IsMouseOverTowerUI();
 void HandleTowerSelection();
+bool UpgradeTower(int towerIndex);
 void HandleTowerUpgrade();
-void DrawTowers();
+void DrawTowerUpgradeButton(const Tower& tower);
+void DrawTowers(const RenderSnapshot& snapshot);
 void HandleTowerFiring();
 void ActivateTowerAbility(Tower& tower);
+const char* GetTargetingPolicyName(TargetingPolicy policy);
+void HandleTargetingPolicyButton();
+void DrawTargetingPolicyButton(const Tower& tower);
 void HandleTowerAbilityButton();
+void DrawTowerAbilityButton(const Tower& tower);
 void RepairTower(Tower& tower);
+void ResetTowerDeadlines();
+void ProcessTowerDeadlines();
 Enemy CreateEnemy(EnemyType type, Vector2 startPosition);
+shared_ptr<const PathRoute> BuildPathRoute(Vector2 start, const vector<Vector2>& points);
+void SetEnemyPath(Enemy& enemy, const vector<Vector2Int>& path);
 void UpdateEnemies();
-void DrawEnemies();
+void ApplyEnemySlow(Enemy& enemy, float duration);
+void ApplyEnemyBurning(Enemy& enemy, float duration, int damage, int sourceTower);
+void UpdateEnemyStatuses();
+void ApplyEnemySeparation();
+float GetEnemyRemainingDistance(const Enemy& enemy);
+void DrawEnemies(const RenderSnapshot& snapshot);
 void UpdateProjectiles();
-void DrawProjectiles();
+void DrawProjectiles(const RenderSnapshot& snapshot);
 void ResetGame();
 void DrawGridHighlight();
 void UpdateGameElements();
 void HandleTowerMenuClick();
 void DrawMenuScreen();
-void DrawGameElements();
+void DrawGameElements(const RenderSnapshot& snapshot);
 void DrawSelectedTowerInfo();
+void HandleSelectedTowerPanel();
+void DrawHud();
+int GetWaveLeaderMarkerX();
 void DrawWaveProgressBar();
+void DrawWaveLeaderMarker();
 void DrawPauseButton();
 void DrawSkipWaveButton();
 void HandlePauseButton();
 void HandleSkipWaveButton();
+void StepSimulation();
+int GetSpeedMultiplier(SimSpeed speed);
+const char* GetSpeedLabel(SimSpeed speed);
+void RunSimulationTicks();
+void DrawSpeedButton();
+void HandleSpeedButton();
 void DrawPauseScreen();
-void DrawVisualEffects();
+void SpawnVisualEffect(const VisualEffect& effect);
+void SpawnLaserBeam(const LaserBeam& beam);
+void SpawnProjectile(const Projectile& projectile);
+void UpdateEffectLifetimes();
+void DrawVisualEffects(const RenderSnapshot& snapshot);
 void DrawTowerTooltip(TowerType type, Vector2 position);
+void DrawTowerTooltipPanel(TowerType type, float tooltipX, float tooltipY);
 void UpdateWeatherParticles();
 void DrawWeatherParticles();
-void UpdateTowerMalfunctions();
 void DrawRainyAtmosphereOverlay();
 
+// Entity storage (ecs.cpp)
+EntityHandle CreateEntity(ComponentMask mask);
+bool IsEntityAlive(EntityHandle entity);
+void DestroyEntity(EntityHandle entity);
+ComponentMask GetEntityMask(EntityHandle entity);
+bool HasComponent(EntityHandle entity, ComponentType type);
+void AddComponent(EntityHandle entity, ComponentType type);
+void RemoveComponent(EntityHandle entity, ComponentType type);
+void* GetComponentData(EntityHandle entity, ComponentType type);
+void QueryArchetypes(ComponentMask required, vector<Archetype*>& outArchetypes);
+void ClearEntities();
+
+// Render snapshots and the simulation thread (snapshot.cpp)
+void BuildRenderSnapshot(RenderSnapshot& snapshot);
+const RenderSnapshot& GetRenderSnapshot();
+void ResetRenderSnapshots();
+void StartSimulationFrame();
+void FinishSimulationFrame();
+void StopSimulationThread();
+bool IsSimulationThreadRunning();
+
+// Cached UI layers (ui.cpp)
+void DrawCachedHud();
+void DrawCachedTooltip(TowerType type, Vector2 position);
+void UnloadUiLayers();
+
+// Allocation tracking (alloctrack.cpp)
+void SetAllocationTag(AllocationTag tag);
+void BeginAllocationFrame();
+bool EndAllocationFrame();
+const AllocationFrameStats& GetAllocationFrameStats();
+void DrawAllocationOverlay();
+
+// Batched environments for automated agents (env.cpp). Each instance is a forked worker process,
+// which has these limits:
+// - POSIX only.
+// - Observation buffers must come from AllocateEnvironmentBuffer (shared mappings the workers
+//   write into); ordinary heap memory would be copied into each worker and never written back.
+// - The batch must be created before any other thread exists, because fork only carries the
+//   calling thread. A running game (sim thread, asset workers, telemetry writer) cannot host one,
+//   and CreateEnvironmentBatch refuses once any of those threads has started.
+void* AllocateEnvironmentBuffer(size_t bytes);
+void FreeEnvironmentBuffer(void* buffer, size_t bytes);
+int GetEnvironmentTileCount(const EnvBatchConfig& config);
+bool CreateEnvironmentBatch(const EnvBatchConfig& config, const EnvObservation& observation);
+bool StepEnvironments(const EnvAction* actions, int actionCount, int ticks);
+void DestroyEnvironmentBatch();
+int RunEnvironmentBenchmark(int instanceCount);
+
+// Timeline tracing (trace.cpp)
+void SetTraceThreadName(const char* name);
+void BeginTraceScope(const char* name);
+void EndTraceScope();
+void StartTraceCapture();
+void StopTraceCapture();
+void SetTraceOutputPath(const string& path);
+void HandleTraceCapture();
+
+// Combat telemetry (telemetry.cpp)
+bool StartTelemetry(const string& path);
+void StopTelemetry();
+bool IsTelemetryRunning();
+void RecordTowerShot(int towerIndex);
+void RecordTowerDamage(int towerIndex, DamageSource source, int damage, int hpAfter);
+void RecordTowerPlaced(int towerIndex);
+void RecordTowerUpgraded(int towerIndex, int cost);
+void RecordTowerMalfunction(int towerIndex, bool malfunctioning);
+void RecordWaveStart(int waveIndex);
+void RecordWaveEnd(int waveIndex);
+void RecordTelemetryReset();
+
+// Startup textures (assets.cpp)
+Texture2D CreateFallbackTexture(Color color);
+bool PackAssetFiles(const string& outputPath, const vector<string>& inputPaths);
+bool OpenAssetPack();
+void QueueTextureLoad(const char* fileName, Texture2D* target, Color fallbackColor);
+void StartAssetDecoding();
+void UploadDecodedAssets();
+void ReportFirstFrame();
+void UnloadAssets();
+bool AreAssetWorkersRunning();
+
+// Map files (map.cpp)
+bool ParseMapText(const string& source, vector<uint8_t>& outImage);
+bool LoadMapFile(const string& path, GameMap& map);
+bool CompileMapFile(const string& sourcePath, const string& outputPath);
+string BuildBuiltinMapSource(MapDifficulty difficulty, int columns, int rows);
+void LoadCurrentMap();
+Vector2Int GetMapSpawnTile();
+Vector2Int GetMapGoalTile();
+bool IsGoalTile(Vector2Int tile);
+TileArt GetTileArt(int col, int row);
+
+// Enemy query layer (targeting.cpp)
+void BuildEnemyQueryIndex();
+void QueryEnemiesInRadius(Vector2 center, float radius, vector<int>& outIndices);
+int GetEnemyCellIndex(Vector2 position);
+Enemy* FindEnemyById(int id);
+Enemy* AcquireTarget(const Tower& tower);
+void AcquireTargetsFromCoverage(const vector<int>& towerIndices);
+void BuildEnemyProgressIndex();
+void ProcessEscapedEnemies();
+void CompactEnemies();
+int GetAliveEnemyCount();
+const Enemy* GetLeadingEnemy();
+Enemy* FindLeadingEnemyInRange(Tower& tower);
+
+// Queued path requests (pathservice.cpp)
+void RequestEnemyPath(Enemy& enemy);
+void RequestPathsThroughTile(Vector2Int tile);
+const vector<Vector2Int>* GetFinishedPath(Vector2Int start);
+void ProcessPathRequests();
+void ResetPathRequests();
+
+// Wave spawning (waves.cpp)
+SpawnTimeline CompileWave(const EnemyWave& wave);
+bool HasWave(int index);
+EnemyWave GetWaveDefinition(int index);
+void StartWave(int index);
+void SpawnDueEnemies();
+
+// Hierarchical pathfinding (hpa.cpp)
+void ResetPathClusters();
+void MarkPathClustersDirty(int col, int row);
+void RebuildDirtyClusters();
+vector<Vector2Int> FindHierarchicalPath(Vector2Int start, int maxTiles, int& searchSteps);
+bool WouldBlockRoute(Vector2Int gridCoords);
+int RunPathBenchmark();
+
+// Batched geometry kernels (geometry.cpp)
+int SelectPointsInRadius(const float* xs, const float* ys, int count, Vector2 center, float radius, int* outIndices);
+const char* GetGeometryKernelName();
+int RunGeometryKernelBenchmark();
+
+// Tower coverage map (coverage.cpp)
+void ResetTowerCoverage();
+void AddTowerCoverage(int towerIndex);
+void RemoveTowerCoverage(int towerIndex);
+const vector<int>* GetTowersCoveringTile(Vector2Int gridCoords);
+void UpdateEnemyTileOccupancy();
+void ReleaseEnemyTile(Enemy& enemy);
+const vector<int>& GetAwakeTowers();
+void HandleCoverageHeatmapToggle();
+void DrawCoverageHeatmap(const RenderSnapshot& snapshot);
+
+inline ComponentMask ComponentBit(ComponentType type) {
+    return 1u << type;
+}
+
+template<typename T> T* GetComponent(EntityHandle entity, ComponentType type) {
+    return (T*)GetComponentData(entity, type);
+}
+
+template<typename T> T* GetComponentColumn(Archetype& archetype, ComponentType type) {
+    // Null when the archetype lacks the component
+    return (archetype.mask & ComponentBit(type)) ? (T*)archetype.columns[type].data() : nullptr;
+}
+
+inline bool IsInsideGrid(int col, int row) {
+    return col >= 0 && col < gridColumns && row >= 0 && row < gridRows;
+}
+
+inline bool IsTileWalkable(int col, int row) {
+    uint64_t chunk = grid.chunks[(row / gridChunkSize) * grid.chunkColumns + col / gridChunkSize];
+    return (chunk >> ((row % gridChunkSize) * gridChunkSize + col % gridChunkSize)) & 1;
+}
+
 #endif // GAME_H
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "game.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#define GEOMETRY_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define GEOMETRY_NEON 1
+#endif
+
+// Batched point-in-radius tests over structure-of-arrays positions. Every kernel computes
+// dx*dx + dy*dy with separate multiplies and adds (no FMA), so all of them agree bit for bit
+// with the scalar version, and keeps points strictly inside the radius like Vector2DistanceSqr < r*r.
+
+typedef int (*SelectPointsKernel)(const float* xs, const float* ys, int count, float cx, float cy, float radiusSq, int* outIndices);
+
+static int SelectPointsScalar(const float* xs, const float* ys, int count, float cx, float cy, float radiusSq, int* outIndices) {
+    int hits = 0;
+    for (int i = 0; i < count; i++) {
+        float dx = xs[i] - cx;
+        float dy = ys[i] - cy;
+        float dxSq = dx * dx;
+        float dySq = dy * dy;
+        if (dxSq + dySq < radiusSq) outIndices[hits++] = i;
+    }
+    return hits;
+}
+
+#if GEOMETRY_X86
+static int SelectPointsSSE2(const float* xs, const float* ys, int count, float cx, float cy, float radiusSq, int* outIndices) {
+    __m128 centerX = _mm_set1_ps(cx), centerY = _mm_set1_ps(cy), limit = _mm_set1_ps(radiusSq);
+    int hits = 0, i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), centerX);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), centerY);
+        __m128 distanceSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(distanceSq, limit));
+        while (mask != 0) {
+            outIndices[hits++] = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    int tail = SelectPointsScalar(xs + i, ys + i, count - i, cx, cy, radiusSq, outIndices + hits);
+    for (int t = 0; t < tail; t++) outIndices[hits + t] += i;
+    return hits + tail;
+}
+
+__attribute__((target("avx2")))
+static int SelectPointsAVX2(const float* xs, const float* ys, int count, float cx, float cy, float radiusSq, int* outIndices) {
+    __m256 centerX = _mm256_set1_ps(cx), centerY = _mm256_set1_ps(cy), limit = _mm256_set1_ps(radiusSq);
+    int hits = 0, i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), centerX);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), centerY);
+        __m256 distanceSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(distanceSq, limit, _CMP_LT_OQ));
+        while (mask != 0) {
+            outIndices[hits++] = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    int tail = SelectPointsSSE2(xs + i, ys + i, count - i, cx, cy, radiusSq, outIndices + hits);
+    for (int t = 0; t < tail; t++) outIndices[hits + t] += i;
+    return hits + tail;
+}
+#endif
+
+#if GEOMETRY_NEON
+static int SelectPointsNEON(const float* xs, const float* ys, int count, float cx, float cy, float radiusSq, int* outIndices) {
+    float32x4_t centerX = vdupq_n_f32(cx), centerY = vdupq_n_f32(cy), limit = vdupq_n_f32(radiusSq);
+    const uint32_t laneBits[4] = { 1, 2, 4, 8 };
+    uint32x4_t laneMask = vld1q_u32(laneBits);
+    int hits = 0, i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t dx = vsubq_f32(vld1q_f32(xs + i), centerX);
+        float32x4_t dy = vsubq_f32(vld1q_f32(ys + i), centerY);
+        float32x4_t distanceSq = vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy));
+        uint32_t mask = vaddvq_u32(vandq_u32(vcltq_f32(distanceSq, limit), laneMask));
+        while (mask != 0) {
+            outIndices[hits++] = i + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    int tail = SelectPointsScalar(xs + i, ys + i, count - i, cx, cy, radiusSq, outIndices + hits);
+    for (int t = 0; t < tail; t++) outIndices[hits + t] += i;
+    return hits + tail;
+}
+#endif
+
+static SelectPointsKernel selectPointsKernel = nullptr;
+static const char* selectPointsKernelName = "scalar";
+
+static void ChooseGeometryKernels() {
+    selectPointsKernel = SelectPointsScalar;
+#if GEOMETRY_X86
+    selectPointsKernel = SelectPointsSSE2;
+    selectPointsKernelName = "SSE2";
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        selectPointsKernel = SelectPointsAVX2;
+        selectPointsKernelName = "AVX2";
+    }
+#elif GEOMETRY_NEON
+    selectPointsKernel = SelectPointsNEON;
+    selectPointsKernelName = "NEON";
+#endif
+}
+
+int SelectPointsInRadius(const float* xs, const float* ys, int count, Vector2 center, float radius, int* outIndices) {
+    if (selectPointsKernel == nullptr) ChooseGeometryKernels();
+    if (count <= 0) return 0;
+    return selectPointsKernel(xs, ys, count, center.x, center.y, radius * radius, outIndices);
+}
+
+const char* GetGeometryKernelName() {
+    if (selectPointsKernel == nullptr) ChooseGeometryKernels();
+    return selectPointsKernelName;
+}
+
+int RunGeometryKernelBenchmark() {
+    // Checks every kernel this CPU can run against the scalar one, then times them
+    struct NamedKernel { const char* name; SelectPointsKernel kernel; };
+    vector<NamedKernel> kernels = { { "scalar", SelectPointsScalar } };
+#if GEOMETRY_X86
+    kernels.push_back({ "SSE2", SelectPointsSSE2 });
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) kernels.push_back({ "AVX2", SelectPointsAVX2 });
+#elif GEOMETRY_NEON
+    kernels.push_back({ "NEON", SelectPointsNEON });
+#endif
+    mt19937 rng(1234);
+    uniform_real_distribution<float> coordinate(0.0f, 2000.0f);
+    const int pointCount = 4099; // Not a multiple of the vector width, so the tails are exercised
+    vector<float> xs(pointCount), ys(pointCount);
+    for (int i = 0; i < pointCount; i++) {
+        xs[i] = coordinate(rng);
+        ys[i] = coordinate(rng);
+    }
+    vector<int> expected(pointCount), actual(pointCount);
+    int failures = 0;
+    for (int trial = 0; trial < 2000; trial++) {
+        float cx = coordinate(rng), cy = coordinate(rng), radius = coordinate(rng) * 0.25f;
+        int offset = trial % 7, count = pointCount - offset - trial % 5;
+        if (trial % 3 == 0) {
+            // Put a point exactly on the radius to pin down the strict comparison
+            xs[offset] = cx + radius;
+            ys[offset] = cy;
+        }
+        int expectedHits = SelectPointsScalar(xs.data() + offset, ys.data() + offset, count, cx, cy, radius * radius, expected.data());
+        for (const auto& entry : kernels) {
+            int hits = entry.kernel(xs.data() + offset, ys.data() + offset, count, cx, cy, radius * radius, actual.data());
+            if (hits != expectedHits || !equal(expected.begin(), expected.begin() + hits, actual.begin())) {
+                if (failures++ < 5) printf("MISMATCH: %s trial %d (%d hits, expected %d)\n", entry.name, trial, hits, expectedHits);
+            }
+        }
+    }
+    printf("Geometry kernels: %zu checked, %d mismatches, dispatch picks %s\n", kernels.size(), failures, GetGeometryKernelName());
+    for (const auto& entry : kernels) {
+        const int repeats = 20000;
+        long total = 0;
+        auto start = chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++) {
+            total += entry.kernel(xs.data(), ys.data(), pointCount, xs[r % pointCount], ys[r % pointCount], 150.0f * 150.0f, actual.data());
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        printf("  %-6s %7.2f ns/point  (%ld hits)\n", entry.name, seconds * 1e9 / ((double)repeats * pointCount), total);
+    }
+    return failures == 0 ? 0 : 1;
+}
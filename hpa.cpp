@@ -0,0 +1,410 @@
+#include "game.h"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <queue>
+#include <random>
+
+// Hierarchical paths (HPA*) for large maps. The grid is cut into square clusters; every run of
+// open tiles along a shared cluster border gets one or two entrances, and each cluster stores the
+// in-cluster step counts between its own entrances. A route is an A* search over that entrance
+// graph, turned back into tiles one cluster at a time and only as far as the caller asks. Changing
+// a tile marks its cluster (plus the neighbour across a border tile) for a rebuild on the next query.
+// The path service routes enemies through here, and placement checks use it to test whether a tile
+// would cut the spawn off from the goal.
+
+struct ClusterNode {
+    int cell; // Tile on this cluster's side of an entrance, or the goal tile
+    int partnerCell; // Tile across the border, -1 for the goal node
+    vector<pair<int, int>> edges; // (node index in this cluster, steps) for nodes reachable inside the cluster
+};
+
+struct PathCluster {
+    vector<ClusterNode> nodes;
+    bool dirty;
+};
+
+// Entrance graph nodes are named cluster * maxClusterNodes + index. Runs along a border are split
+// by closed tiles, so a border holds at most one entrance per two tiles, plus the goal node
+const int maxClusterNodes = 4 * ((pathClusterSize + 1) / 2) + 1;
+
+static vector<PathCluster> pathClusters;
+static vector<int> dirtyClusters;
+static int clusterColumns = 0;
+static int clusterRows = 0;
+// A* scratch over entrance graph nodes; an entry is current only when its stamp matches
+static vector<int> nodeSearchStamp;
+static vector<int> nodeCost;
+static vector<int> nodeParent;
+static int nodeStamp = 0;
+// In-cluster BFS scratch, indexed by tile within the cluster
+static vector<int> localDistance;
+static vector<int> localParent;
+static vector<int> localQueue;
+
+static int GetClusterIndex(int col, int row) {
+    return (row / pathClusterSize) * clusterColumns + col / pathClusterSize;
+}
+
+void ResetPathClusters() {
+    clusterColumns = (gridColumns + pathClusterSize - 1) / pathClusterSize;
+    clusterRows = (gridRows + pathClusterSize - 1) / pathClusterSize;
+    pathClusters.assign((size_t)clusterColumns * clusterRows, { {}, true });
+    dirtyClusters.resize(pathClusters.size());
+    for (int i = 0; i < (int)pathClusters.size(); i++) dirtyClusters[i] = i;
+    nodeSearchStamp.assign(pathClusters.size() * maxClusterNodes, 0);
+    nodeCost.resize(pathClusters.size() * maxClusterNodes);
+    nodeParent.resize(pathClusters.size() * maxClusterNodes);
+    nodeStamp = 0;
+}
+
+static void MarkClusterDirty(int col, int row) {
+    PathCluster& cluster = pathClusters[GetClusterIndex(col, row)];
+    if (cluster.dirty) return;
+    cluster.dirty = true;
+    dirtyClusters.push_back(GetClusterIndex(col, row));
+}
+
+void MarkPathClustersDirty(int col, int row) {
+    if (pathClusters.empty()) return;
+    MarkClusterDirty(col, row);
+    // A border tile also decides the entrances of the cluster across that border
+    if (col % pathClusterSize == 0 && col > 0) MarkClusterDirty(col - 1, row);
+    if (col % pathClusterSize == pathClusterSize - 1 && col + 1 < gridColumns) MarkClusterDirty(col + 1, row);
+    if (row % pathClusterSize == 0 && row > 0) MarkClusterDirty(col, row - 1);
+    if (row % pathClusterSize == pathClusterSize - 1 && row + 1 < gridRows) MarkClusterDirty(col, row + 1);
+}
+
+static void AddBorderEntrances(PathCluster& cluster, int clusterCol, int clusterRow, int dx, int dy) {
+    // Entrances toward the neighbour at (dx, dy). Both clusters derive the same entrances from the
+    // grid, so they agree without sharing state: one in the middle of each open run, or one at each
+    // end of runs long enough that a single door would force a detour
+    int neighborCol = clusterCol + dx, neighborRow = clusterRow + dy;
+    if (neighborCol < 0 || neighborCol >= clusterColumns || neighborRow < 0 || neighborRow >= clusterRows) return;
+    int firstCol = clusterCol * pathClusterSize, firstRow = clusterRow * pathClusterSize;
+    int length = dx != 0 ? min(pathClusterSize, gridRows - firstRow) : min(pathClusterSize, gridColumns - firstCol);
+    auto borderTile = [&](int i, Vector2Int& own, Vector2Int& across) {
+        if (dx != 0) {
+            own = { dx > 0 ? min(firstCol + pathClusterSize, gridColumns) - 1 : firstCol, firstRow + i };
+            across = { own.x + dx, own.y };
+        } else {
+            own = { firstCol + i, dy > 0 ? min(firstRow + pathClusterSize, gridRows) - 1 : firstRow };
+            across = { own.x, own.y + dy };
+        }
+    };
+    auto addEntrance = [&](int i) {
+        Vector2Int own, across;
+        borderTile(i, own, across);
+        cluster.nodes.push_back({ own.y * gridColumns + own.x, across.y * gridColumns + across.x, {} });
+    };
+    int runStart = -1;
+    for (int i = 0; i <= length; i++) {
+        bool open = false;
+        if (i < length) {
+            Vector2Int own, across;
+            borderTile(i, own, across);
+            open = IsTileWalkable(own.x, own.y) && IsTileWalkable(across.x, across.y);
+        }
+        if (open && runStart < 0) runStart = i;
+        if (open || runStart < 0) continue;
+        if (i - runStart >= 6) {
+            addEntrance(runStart);
+            addEntrance(i - 1);
+        } else {
+            addEntrance((runStart + i - 1) / 2);
+        }
+        runStart = -1;
+    }
+}
+
+static int SearchCluster(int clusterIndex, int startCell) {
+    // BFS confined to one cluster; fills localDistance (-1 unreached) and localParent, returns the tiles visited
+    int clusterCol = clusterIndex % clusterColumns, clusterRow = clusterIndex / clusterColumns;
+    int firstCol = clusterCol * pathClusterSize, firstRow = clusterRow * pathClusterSize;
+    int lastCol = min(firstCol + pathClusterSize, gridColumns) - 1, lastRow = min(firstRow + pathClusterSize, gridRows) - 1;
+    localDistance.assign(pathClusterSize * pathClusterSize, -1);
+    localParent.resize(pathClusterSize * pathClusterSize);
+    localQueue.resize(pathClusterSize * pathClusterSize);
+    auto toLocal = [&](int col, int row) { return (row - firstRow) * pathClusterSize + (col - firstCol); };
+    int startLocal = toLocal(startCell % gridColumns, startCell / gridColumns);
+    int head = 0, tail = 0;
+    localQueue[tail++] = startLocal;
+    localDistance[startLocal] = 0;
+    localParent[startLocal] = -1;
+    int dx[] = {0, 0, 1, -1};
+    int dy[] = {-1, 1, 0, 0};
+    while (head < tail) {
+        int current = localQueue[head++];
+        int col = firstCol + current % pathClusterSize, row = firstRow + current / pathClusterSize;
+        for (int i = 0; i < 4; ++i) {
+            int nx = col + dx[i], ny = row + dy[i];
+            if (nx < firstCol || nx > lastCol || ny < firstRow || ny > lastRow || !IsTileWalkable(nx, ny)) continue;
+            int neighbor = toLocal(nx, ny);
+            if (localDistance[neighbor] >= 0) continue;
+            localDistance[neighbor] = localDistance[current] + 1;
+            localParent[neighbor] = current;
+            localQueue[tail++] = neighbor;
+        }
+    }
+    return tail;
+}
+
+static int GetLocalIndex(int clusterIndex, int cell) {
+    int firstCol = (clusterIndex % clusterColumns) * pathClusterSize, firstRow = (clusterIndex / clusterColumns) * pathClusterSize;
+    return (cell / gridColumns - firstRow) * pathClusterSize + (cell % gridColumns - firstCol);
+}
+
+static void AppendClusterPath(int clusterIndex, int endCell, vector<Vector2Int>& path) {
+    // Appends the tiles after the last SearchCluster start up to endCell
+    int firstCol = (clusterIndex % clusterColumns) * pathClusterSize, firstRow = (clusterIndex / clusterColumns) * pathClusterSize;
+    size_t begin = path.size();
+    for (int local = GetLocalIndex(clusterIndex, endCell); localParent[local] >= 0; local = localParent[local]) {
+        path.push_back({ firstCol + local % pathClusterSize, firstRow + local / pathClusterSize });
+    }
+    reverse(path.begin() + begin, path.end());
+}
+
+static void RebuildCluster(int clusterIndex) {
+    PathCluster& cluster = pathClusters[clusterIndex];
+    int clusterCol = clusterIndex % clusterColumns, clusterRow = clusterIndex / clusterColumns;
+    cluster.nodes.clear();
+    AddBorderEntrances(cluster, clusterCol, clusterRow, 1, 0);
+    AddBorderEntrances(cluster, clusterCol, clusterRow, -1, 0);
+    AddBorderEntrances(cluster, clusterCol, clusterRow, 0, 1);
+    AddBorderEntrances(cluster, clusterCol, clusterRow, 0, -1);
+    Vector2Int goal = GetMapGoalTile();
+    if (GetClusterIndex(goal.x, goal.y) == clusterIndex && IsTileWalkable(goal.x, goal.y)) {
+        cluster.nodes.push_back({ goal.y * gridColumns + goal.x, -1, {} });
+    }
+    // Steps are symmetric, so one search per node fills both directions of its later edges
+    for (int i = 0; i < (int)cluster.nodes.size(); i++) {
+        SearchCluster(clusterIndex, cluster.nodes[i].cell);
+        for (int j = i + 1; j < (int)cluster.nodes.size(); j++) {
+            int steps = localDistance[GetLocalIndex(clusterIndex, cluster.nodes[j].cell)];
+            if (steps < 0) continue;
+            cluster.nodes[i].edges.push_back({ j, steps });
+            cluster.nodes[j].edges.push_back({ i, steps });
+        }
+    }
+    cluster.dirty = false;
+}
+
+void RebuildDirtyClusters() {
+    TraceScope trace("RebuildDirtyClusters");
+    for (int clusterIndex : dirtyClusters) RebuildCluster(clusterIndex);
+    dirtyClusters.clear();
+}
+
+static int FindPartnerNode(const ClusterNode& node) {
+    // The entrance graph node on the other side of the border, -1 for the goal node
+    if (node.partnerCell < 0) return -1;
+    int partnerCluster = GetClusterIndex(node.partnerCell % gridColumns, node.partnerCell / gridColumns);
+    const vector<ClusterNode>& candidates = pathClusters[partnerCluster].nodes;
+    for (int i = 0; i < (int)candidates.size(); i++) {
+        if (candidates[i].cell == node.partnerCell && candidates[i].partnerCell == node.cell) return partnerCluster * maxClusterNodes + i;
+    }
+    return -1;
+}
+
+static const ClusterNode& GetClusterNode(int node) {
+    return pathClusters[node / maxClusterNodes].nodes[node % maxClusterNodes];
+}
+
+vector<Vector2Int> FindHierarchicalPath(Vector2Int start, int maxTiles, int& searchSteps) {
+    // maxTiles > 0 refines only the first part of the route; ask again further along for the rest.
+    // searchSteps gets the entrances settled plus the tiles searched, for callers on a work budget
+    searchSteps = 0;
+    if (!IsInsideGrid(start.x, start.y) || !IsTileWalkable(start.x, start.y) || pathClusters.empty()) return {};
+    RebuildDirtyClusters();
+    Vector2Int goal = GetMapGoalTile();
+    auto estimate = [goal](int cell) { return abs(cell % gridColumns - goal.x) + abs(cell / gridColumns - goal.y); };
+    int startCell = start.y * gridColumns + start.x;
+    int startCluster = GetClusterIndex(start.x, start.y);
+
+    // A* over entrances, seeded with every entrance of the start cluster reachable from the start tile
+    nodeStamp++;
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> frontier;
+    auto reach = [&](int node, int cost, int parent) {
+        if (nodeSearchStamp[node] == nodeStamp && nodeCost[node] <= cost) return;
+        nodeSearchStamp[node] = nodeStamp;
+        nodeCost[node] = cost;
+        nodeParent[node] = parent;
+        frontier.push({ cost + estimate(GetClusterNode(node).cell), node });
+    };
+    searchSteps += SearchCluster(startCluster, startCell);
+    for (int i = 0; i < (int)pathClusters[startCluster].nodes.size(); i++) {
+        int steps = localDistance[GetLocalIndex(startCluster, pathClusters[startCluster].nodes[i].cell)];
+        if (steps >= 0) reach(startCluster * maxClusterNodes + i, steps, -1);
+    }
+    int goalNode = -1;
+    while (!frontier.empty()) {
+        auto [priority, node] = frontier.top();
+        frontier.pop();
+        const ClusterNode& current = GetClusterNode(node);
+        if (priority != nodeCost[node] + estimate(current.cell)) continue; // Superseded by a cheaper entry
+        searchSteps++;
+        if (current.partnerCell < 0) {
+            goalNode = node;
+            break;
+        }
+        int cluster = node / maxClusterNodes;
+        for (const auto& edge : current.edges) reach(cluster * maxClusterNodes + edge.first, nodeCost[node] + edge.second, node);
+        int partner = FindPartnerNode(current);
+        if (partner >= 0) reach(partner, nodeCost[node] + 1, node);
+    }
+    if (goalNode < 0) return {};
+    vector<int> hops;
+    for (int node = goalNode; node >= 0; node = nodeParent[node]) hops.push_back(node);
+    reverse(hops.begin(), hops.end());
+
+    // Expand hop by hop: a border crossing is one tile, a hop inside a cluster is a local search
+    vector<Vector2Int> path = { start };
+    searchSteps += SearchCluster(startCluster, startCell);
+    AppendClusterPath(startCluster, GetClusterNode(hops[0]).cell, path);
+    for (size_t i = 1; i < hops.size() && (maxTiles <= 0 || (int)path.size() < maxTiles); i++) {
+        const ClusterNode& from = GetClusterNode(hops[i - 1]);
+        const ClusterNode& to = GetClusterNode(hops[i]);
+        if (hops[i] / maxClusterNodes != hops[i - 1] / maxClusterNodes) {
+            path.push_back({ to.cell % gridColumns, to.cell / gridColumns });
+            continue;
+        }
+        searchSteps += SearchCluster(hops[i] / maxClusterNodes, from.cell);
+        AppendClusterPath(hops[i] / maxClusterNodes, to.cell, path);
+    }
+    searchSteps += (int)path.size();
+    return path;
+}
+
+bool WouldBlockRoute(Vector2Int gridCoords) {
+    // A downhill walk of the goal distance field from the spawn that can step around the tile proves
+    // it is no cut, which settles most tiles. Otherwise try it: block, search the entrance graph from
+    // the spawn, restore; only the tile's clusters change, and one entrance per open border run keeps
+    // the graph exact about reachability. Answers hold until the grid changes, so hovering is cheap
+    static Vector2Int checkedTile = {-1, -1};
+    static int checkedVersion = -1;
+    static bool checkedBlocks = false;
+    if (!IsInsideGrid(gridCoords.x, gridCoords.y) || pathClusters.empty()) return false;
+    Vector2Int spawn = GetMapSpawnTile();
+    if ((gridCoords.x == spawn.x && gridCoords.y == spawn.y) || IsGoalTile(gridCoords)) return true;
+    if (!IsTileWalkable(gridCoords.x, gridCoords.y)) return false;
+    if (checkedVersion == gridVersion && checkedTile.x == gridCoords.x && checkedTile.y == gridCoords.y) return checkedBlocks;
+    checkedTile = gridCoords;
+    checkedVersion = gridVersion;
+    checkedBlocks = false;
+    int spawnDistance = GetGoalDistance(spawn);
+    if (spawnDistance < 0) return false; // Already cut off; nothing left to protect
+    int dx[] = {0, 0, 1, -1};
+    int dy[] = {-1, 1, 0, 0};
+    Vector2Int current = spawn;
+    bool avoided = true;
+    for (int distance = spawnDistance; distance > 0 && avoided; --distance) {
+        avoided = false;
+        for (int i = 0; i < 4; ++i) {
+            Vector2Int neighbor = {current.x + dx[i], current.y + dy[i]};
+            if ((neighbor.x == gridCoords.x && neighbor.y == gridCoords.y) || GetGoalDistance(neighbor) != distance - 1) continue;
+            current = neighbor;
+            avoided = true;
+            break;
+        }
+    }
+    if (avoided) return false;
+    int searchSteps;
+    SetTileWalkable(gridCoords.x, gridCoords.y, false);
+    checkedBlocks = FindHierarchicalPath(spawn, 1, searchSteps).empty();
+    SetTileWalkable(gridCoords.x, gridCoords.y, true);
+    return checkedBlocks;
+}
+
+int RunPathBenchmark() {
+    // Random obstacle fields on growing square maps: flat BFS per route against the entrance graph,
+    // plus what one tower placement costs each way (whole distance field vs. local repair)
+    printf("Path benchmark (cluster size %d)\n", pathClusterSize);
+    printf("  %-6s %12s %12s %12s %12s %14s %14s %8s\n", "size", "bfs ms", "hpa ms", "hpa part ms", "build ms", "field ms/tower", "local ms/tower", "length");
+    mt19937 rng(99);
+    int failures = 0;
+    for (int size : { 256, 512, 1024 }) {
+        currentDifficulty = EASY;
+        customMapPath.clear();
+        builtinMapColumns = size;
+        builtinMapRows = size;
+        InitGrid();
+        Vector2Int spawn = GetMapSpawnTile(), goal = GetMapGoalTile();
+        uniform_int_distribution<int> tile(0, size - 1);
+        for (int i = 0; i < size * size / 4; i++) {
+            int col = tile(rng), row = tile(rng);
+            if (abs(col - spawn.x) + abs(row - spawn.y) > 2 && abs(col - goal.x) + abs(row - goal.y) > 2) SetTileWalkable(col, row, false);
+        }
+        auto elapsedMs = [](chrono::steady_clock::time_point start) {
+            return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        };
+        auto start = chrono::steady_clock::now();
+        RebuildDirtyClusters();
+        double buildMs = elapsedMs(start);
+
+        // Route queries from random open tiles
+        vector<Vector2Int> starts;
+        while (starts.size() < 50) {
+            Vector2Int candidate = { tile(rng), tile(rng) };
+            if (IsTileWalkable(candidate.x, candidate.y)) starts.push_back(candidate);
+        }
+        double bfsMs = 0.0, hpaMs = 0.0, partialMs = 0.0;
+        int searchSteps;
+        long long bfsLength = 0, hpaLength = 0;
+        for (const auto& from : starts) {
+            start = chrono::steady_clock::now();
+            vector<Vector2Int> flat = FindPathBFS(from, goal);
+            bfsMs += elapsedMs(start);
+            start = chrono::steady_clock::now();
+            vector<Vector2Int> hierarchical = FindHierarchicalPath(from, 0, searchSteps);
+            hpaMs += elapsedMs(start);
+            start = chrono::steady_clock::now();
+            FindHierarchicalPath(from, pathRefineTiles, searchSteps);
+            partialMs += elapsedMs(start);
+            if (flat.empty() != hierarchical.empty() || (!hierarchical.empty() && (hierarchical.front().x != from.x || hierarchical.front().y != from.y ||
+                hierarchical.back().x != goal.x || hierarchical.back().y != goal.y))) {
+                if (failures++ < 5) printf("MISMATCH: %dx%d from (%d, %d)\n", size, size, from.x, from.y);
+                continue;
+            }
+            for (size_t i = 1; i < hierarchical.size(); i++) {
+                const Vector2Int& a = hierarchical[i - 1];
+                const Vector2Int& b = hierarchical[i];
+                if (abs(a.x - b.x) + abs(a.y - b.y) != 1 || !IsTileWalkable(b.x, b.y)) {
+                    if (failures++ < 5) printf("BROKEN PATH: %dx%d from (%d, %d) at step %zu\n", size, size, from.x, from.y, i);
+                    break;
+                }
+            }
+            bfsLength += flat.size();
+            hpaLength += hierarchical.size();
+        }
+
+        // Tower placements as the game makes them (route check, local field repair, cluster rebuild)
+        // against rebuilding the whole goal distance field, which must come out the same
+        NotifyGridChanged();
+        vector<int> repairedField((size_t)size * size);
+        double fieldMs = 0.0, clusterMs = 0.0;
+        int placements = 0;
+        while (placements < 20) {
+            Vector2Int blocked = { tile(rng), tile(rng) };
+            if (!IsTileWalkable(blocked.x, blocked.y)) continue;
+            start = chrono::steady_clock::now();
+            if (WouldBlockRoute(blocked)) continue;
+            SetTileWalkable(blocked.x, blocked.y, false);
+            NotifyTileBlocked(blocked);
+            RebuildDirtyClusters();
+            clusterMs += elapsedMs(start);
+            for (int cell = 0; cell < size * size; cell++) repairedField[cell] = GetGoalDistance({ cell % size, cell / size });
+            start = chrono::steady_clock::now();
+            BuildGoalDistanceField();
+            fieldMs += elapsedMs(start);
+            for (int cell = 0; cell < size * size; cell++) {
+                if (repairedField[cell] == GetGoalDistance({ cell % size, cell / size })) continue;
+                if (failures++ < 5) printf("FIELD MISMATCH: %dx%d at (%d, %d) after blocking (%d, %d)\n", size, size, cell % size, cell / size, blocked.x, blocked.y);
+                break;
+            }
+            placements++;
+        }
+        printf("  %-6d %12.3f %12.3f %12.3f %12.1f %14.3f %14.3f %7.3fx\n", size, bfsMs / starts.size(), hpaMs / starts.size(), partialMs / starts.size(),
+               buildMs, fieldMs / placements, clusterMs / placements, bfsLength > 0 ? (double)hpaLength / bfsLength : 0.0);
+    }
+    return failures == 0 ? 0 : 1;
+}
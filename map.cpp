@@ -0,0 +1,281 @@
+#include "game.h"
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Text maps (.tdmap) are line based:
+//   size <columns> <rows>
+//   spawn <col> <row>
+//   goal <col> <row>
+//   weather none|rain|snow
+//   theme easy|medium|hard          default tile art, same rules as the built-in maps
+//   block <col> <row> [<w> <h>]     unwalkable tile or rectangle
+//   art <index> <col> <row> [<w> <h>] override the TileArt index of a tile or rectangle
+// '#' starts a comment. The binary form (.tdmb) is the in-memory image itself: a header
+// followed by the walkable chunk masks (TileGrid layout) and one art byte per tile, so a
+// memory-mapped file is used as-is without parsing.
+
+GameMap currentMap;
+string customMapPath;
+int builtinMapColumns = defaultGridColumns;
+int builtinMapRows = defaultGridRows;
+
+static int GetMapChunkColumns(int columns) {
+    return (columns + gridChunkSize - 1) / gridChunkSize;
+}
+
+static int GetMapChunkRows(int rows) {
+    return (rows + gridChunkSize - 1) / gridChunkSize;
+}
+
+static void PointMapAtImage(GameMap& map, const uint8_t* image) {
+    map.header = (const MapFileHeader*)image;
+    map.walkableChunks = (const uint64_t*)(image + map.header->walkableOffset);
+    map.tileArt = image + map.header->artOffset;
+}
+
+static void UnloadMap(GameMap& map) {
+    if (map.mappedData != nullptr) munmap(map.mappedData, map.mappedSize);
+    map.mappedData = nullptr;
+    map.mappedSize = 0;
+    map.ownedData.clear();
+    map.header = nullptr;
+    map.walkableChunks = nullptr;
+    map.tileArt = nullptr;
+}
+
+static bool ValidateMapImage(const uint8_t* image, size_t size) {
+    if (size < sizeof(MapFileHeader)) return false;
+    const MapFileHeader* header = (const MapFileHeader*)image;
+    if (memcmp(header->magic, mapFileMagic, 4) != 0 || header->version != mapFileVersion || header->fileSize != size) return false;
+    if (header->columns <= 0 || header->rows <= 0 || header->columns > maxMapDimension || header->rows > maxMapDimension) return false;
+    if (header->chunkColumns != GetMapChunkColumns(header->columns) || header->chunkRows != GetMapChunkRows(header->rows)) return false;
+    size_t chunkBytes = (size_t)header->chunkColumns * header->chunkRows * sizeof(uint64_t);
+    size_t artBytes = (size_t)header->columns * header->rows;
+    if (header->walkableOffset % alignof(uint64_t) != 0) return false;
+    if (header->walkableOffset < sizeof(MapFileHeader) || header->walkableOffset + chunkBytes > size) return false;
+    if (header->artOffset < sizeof(MapFileHeader) || header->artOffset + artBytes > size) return false;
+    if (header->spawnCol < 0 || header->spawnCol >= header->columns || header->spawnRow < 0 || header->spawnRow >= header->rows) return false;
+    if (header->goalCol < 0 || header->goalCol >= header->columns || header->goalRow < 0 || header->goalRow >= header->rows) return false;
+    if (header->weather < WEATHER_NONE || header->weather > SNOW) return false;
+    // Art bytes index the tile texture table directly when drawing
+    const uint8_t* art = image + header->artOffset;
+    for (size_t i = 0; i < artBytes; i++) {
+        if (art[i] >= TILE_ART_COUNT) return false;
+    }
+    return true;
+}
+
+static TileArt GetThemeTileArt(MapDifficulty theme, int col, int row, int columns, int rows) {
+    if (theme == MEDIUM) return col == 0 ? TILE_ART_MEDIUM_TOP : TILE_ART_MEDIUM_GRID;
+    if (theme == HARD) return col == columns - 1 ? TILE_ART_HARD_RIGHTMOST : TILE_ART_HARD_GRID;
+    if (col == 0) return TILE_ART_LEFT_EDGE;
+    if (col == columns - 1) return TILE_ART_RIGHT_EDGE;
+    if (col == columns - 2) return TILE_ART_SECOND_RIGHTMOST;
+    if (row == 0) return TILE_ART_TOP_EDGE;
+    if (row == rows - 1) return TILE_ART_BOTTOM_EDGE;
+    return TILE_ART_GRASS;
+}
+
+bool ParseMapText(const string& source, vector<uint8_t>& outImage) {
+    struct RectCommand { int art; int col, row, width, height; };
+    int columns = 0, rows = 0;
+    Vector2Int spawn = {-1, -1}, goal = {-1, -1};
+    WeatherType weather = WEATHER_NONE;
+    MapDifficulty theme = EASY;
+    vector<RectCommand> commands; // art == -1 marks a block command
+
+    istringstream input(source);
+    string line;
+    int lineNumber = 0;
+    while (getline(input, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != string::npos) line.erase(comment);
+        istringstream tokens(line);
+        string keyword;
+        if (!(tokens >> keyword)) continue;
+        bool ok = true;
+        if (keyword == "size") {
+            ok = (bool)(tokens >> columns >> rows);
+        } else if (keyword == "spawn") {
+            ok = (bool)(tokens >> spawn.x >> spawn.y);
+        } else if (keyword == "goal") {
+            ok = (bool)(tokens >> goal.x >> goal.y);
+        } else if (keyword == "weather" || keyword == "theme") {
+            string value;
+            ok = (bool)(tokens >> value);
+            if (keyword == "weather") {
+                if (value == "none") weather = WEATHER_NONE;
+                else if (value == "rain") weather = RAIN;
+                else if (value == "snow") weather = SNOW;
+                else ok = false;
+            } else {
+                if (value == "easy") theme = EASY;
+                else if (value == "medium") theme = MEDIUM;
+                else if (value == "hard") theme = HARD;
+                else ok = false;
+            }
+        } else if (keyword == "block" || keyword == "art") {
+            RectCommand command = { -1, 0, 0, 1, 1 };
+            if (keyword == "art") ok = (bool)(tokens >> command.art) && command.art >= 0 && command.art < TILE_ART_COUNT;
+            ok = ok && (bool)(tokens >> command.col >> command.row);
+            if (ok && tokens >> command.width) ok = (bool)(tokens >> command.height);
+            ok = ok && command.width > 0 && command.height > 0;
+            commands.push_back(command);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            TraceLog(LOG_WARNING, "MAP: Line %d: cannot parse \"%s\"", lineNumber, line.c_str());
+            return false;
+        }
+    }
+    if (columns <= 0 || rows <= 0 || columns > maxMapDimension || rows > maxMapDimension) {
+        TraceLog(LOG_WARNING, "MAP: Missing or invalid size");
+        return false;
+    }
+
+    MapFileHeader header = {};
+    memcpy(header.magic, mapFileMagic, 4);
+    header.version = mapFileVersion;
+    header.columns = columns;
+    header.rows = rows;
+    header.spawnCol = spawn.x;
+    header.spawnRow = spawn.y;
+    header.goalCol = goal.x;
+    header.goalRow = goal.y;
+    header.weather = weather;
+    header.chunkColumns = GetMapChunkColumns(columns);
+    header.chunkRows = GetMapChunkRows(rows);
+    size_t chunkCount = (size_t)header.chunkColumns * header.chunkRows;
+    header.walkableOffset = sizeof(MapFileHeader);
+    header.artOffset = header.walkableOffset + (uint32_t)(chunkCount * sizeof(uint64_t));
+    header.fileSize = header.artOffset + (uint32_t)(columns * rows);
+
+    outImage.assign(header.fileSize, 0);
+    memcpy(outImage.data(), &header, sizeof(header));
+    uint64_t* chunks = (uint64_t*)(outImage.data() + header.walkableOffset);
+    uint8_t* art = outImage.data() + header.artOffset;
+    // Walkable bits are only set inside the map so padding tiles in edge chunks read as blocked
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < columns; col++) {
+            chunks[(row / gridChunkSize) * header.chunkColumns + col / gridChunkSize] |= 1ULL << ((row % gridChunkSize) * gridChunkSize + col % gridChunkSize);
+            art[row * columns + col] = (uint8_t)GetThemeTileArt(theme, col, row, columns, rows);
+        }
+    }
+    for (const auto& command : commands) {
+        for (int row = max(command.row, 0); row < min(command.row + command.height, rows); row++) {
+            for (int col = max(command.col, 0); col < min(command.col + command.width, columns); col++) {
+                if (command.art < 0) chunks[(row / gridChunkSize) * header.chunkColumns + col / gridChunkSize] &= ~(1ULL << ((row % gridChunkSize) * gridChunkSize + col % gridChunkSize));
+                else art[row * columns + col] = (uint8_t)command.art;
+            }
+        }
+    }
+    if (!ValidateMapImage(outImage.data(), outImage.size())) {
+        TraceLog(LOG_WARNING, "MAP: Spawn and goal must lie inside the map");
+        outImage.clear();
+        return false;
+    }
+    return true;
+}
+
+static bool HasExtension(const string& path, const char* extension) {
+    size_t length = strlen(extension);
+    return path.size() >= length && path.compare(path.size() - length, length, extension) == 0;
+}
+
+bool LoadMapFile(const string& path, GameMap& map) {
+    UnloadMap(map);
+    if (HasExtension(path, ".tdmb")) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            TraceLog(LOG_WARNING, "MAP: Cannot open %s", path.c_str());
+            return false;
+        }
+        struct stat info;
+        void* data = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            TraceLog(LOG_WARNING, "MAP: Cannot map %s", path.c_str());
+            return false;
+        }
+        if (!ValidateMapImage((const uint8_t*)data, (size_t)info.st_size)) {
+            TraceLog(LOG_WARNING, "MAP: %s is not a valid binary map", path.c_str());
+            munmap(data, (size_t)info.st_size);
+            return false;
+        }
+        map.mappedData = data;
+        map.mappedSize = (size_t)info.st_size;
+        PointMapAtImage(map, (const uint8_t*)data);
+        return true;
+    }
+    ifstream file(path);
+    if (!file) {
+        TraceLog(LOG_WARNING, "MAP: Cannot open %s", path.c_str());
+        return false;
+    }
+    stringstream source;
+    source << file.rdbuf();
+    if (!ParseMapText(source.str(), map.ownedData)) return false;
+    PointMapAtImage(map, map.ownedData.data());
+    return true;
+}
+
+bool CompileMapFile(const string& sourcePath, const string& outputPath) {
+    GameMap map = {};
+    if (!LoadMapFile(sourcePath, map)) return false;
+    ofstream output(outputPath, ios::binary);
+    bool written = output && output.write((const char*)map.header, map.header->fileSize);
+    UnloadMap(map);
+    if (!written) TraceLog(LOG_WARNING, "MAP: Cannot write %s", outputPath.c_str());
+    return written;
+}
+
+string BuildBuiltinMapSource(MapDifficulty difficulty, int columns, int rows) {
+    // The shipped layouts; spawn and goal follow the middle row so --grid boards still work
+    string source = TextFormat("size %d %d\nspawn 0 %d\ngoal %d %d\n", columns, rows, rows / 2, columns - 1, rows / 2);
+    if (difficulty == MEDIUM) {
+        source += "weather rain\ntheme medium\n"
+                  "block 2 2 4 2\n"
+                  "block 4 6 2 2\n";
+    } else if (difficulty == HARD) {
+        source += "weather snow\ntheme hard\n"
+                  "block 2 2 3 1\n"
+                  "block 10 2 3 1\n"
+                  "block 4 4 3 1\n"
+                  "block 8 6 3 1\n"
+                  "block 3 6 1 2\n";
+    } else {
+        source += "weather none\ntheme easy\n";
+    }
+    return source;
+}
+
+void LoadCurrentMap() {
+    if (!customMapPath.empty() && LoadMapFile(customMapPath, currentMap)) return;
+    UnloadMap(currentMap);
+    ParseMapText(BuildBuiltinMapSource(currentDifficulty, builtinMapColumns, builtinMapRows), currentMap.ownedData);
+    PointMapAtImage(currentMap, currentMap.ownedData.data());
+}
+
+Vector2Int GetMapSpawnTile() {
+    return { currentMap.header->spawnCol, currentMap.header->spawnRow };
+}
+
+Vector2Int GetMapGoalTile() {
+    return { currentMap.header->goalCol, currentMap.header->goalRow };
+}
+
+bool IsGoalTile(Vector2Int tile) {
+    return tile.x == currentMap.header->goalCol && tile.y == currentMap.header->goalRow;
+}
+
+TileArt GetTileArt(int col, int row) {
+    return (TileArt)currentMap.tileArt[row * currentMap.header->columns + col];
+}
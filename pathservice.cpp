@@ -0,0 +1,145 @@
+#include "game.h"
+#include <unordered_map>
+
+// Path requests are queued here and answered on a later tick instead of where they are raised,
+// so a burst (every enemy after a placement) is spread over several ticks by a budget of search
+// steps per tick. Answers come from the cluster hierarchy (hpa.cpp) and cover only the next
+// pathRefineTiles of the route; enemies ask again from further along before they run out.
+// Requests from the same tile share one search, and finished paths are kept until the grid
+// changes so repeat requests cost nothing.
+
+struct PathJob {
+    int startCell;
+    vector<int> enemyIds;
+};
+
+static vector<PathJob> pathJobs;
+static size_t nextPathJob = 0;
+static unordered_map<int, int> pendingPathJobs; // Start cell -> index in pathJobs
+static unordered_map<int, vector<Vector2Int>> finishedPaths; // Start cell -> path, valid for finishedPathsVersion
+static int finishedPathsVersion = -1;
+
+static void DropStaleFinishedPaths() {
+    if (finishedPathsVersion == gridVersion) return;
+    finishedPaths.clear();
+    finishedPathsVersion = gridVersion;
+}
+
+void ResetPathRequests() {
+    pathJobs.clear();
+    nextPathJob = 0;
+    pendingPathJobs.clear();
+    finishedPaths.clear();
+    finishedPathsVersion = -1;
+}
+
+void RequestEnemyPath(Enemy& enemy) {
+    if (enemy.pathRequested) return;
+    Vector2Int start = GetGridCoords(enemy.position);
+    if (!IsInsideGrid(start.x, start.y)) return;
+    int cell = start.y * gridColumns + start.x;
+    enemy.pathRequested = true;
+    auto pending = pendingPathJobs.find(cell);
+    if (pending != pendingPathJobs.end()) {
+        pathJobs[pending->second].enemyIds.push_back(enemy.id);
+        return;
+    }
+    pendingPathJobs[cell] = (int)pathJobs.size();
+    pathJobs.push_back({ cell, { enemy.id } });
+}
+
+void RequestPathsThroughTile(Vector2Int tile) {
+    TraceScope trace("RequestPathsThroughTile");
+    // A path that avoids the tile still works once the tile is blocked, so only enemies about to
+    // step on it need a new one. Paths are partial, so the scan per enemy stays short
+    for (auto& enemy : enemies) {
+        if (!enemy.active) continue;
+        const vector<Vector2Int>& path = enemy.waypointsPath;
+        if (path.empty()) {
+            RequestEnemyPath(enemy);
+            continue;
+        }
+        for (size_t i = enemy.pathIndex > 0 ? enemy.pathIndex - 1 : 0; i < path.size(); i++) {
+            if (path[i].x != tile.x || path[i].y != tile.y) continue;
+            RequestEnemyPath(enemy);
+            break;
+        }
+    }
+}
+
+const vector<Vector2Int>* GetFinishedPath(Vector2Int start) {
+    DropStaleFinishedPaths();
+    if (!IsInsideGrid(start.x, start.y)) return nullptr;
+    auto found = finishedPaths.find(start.y * gridColumns + start.x);
+    return found != finishedPaths.end() ? &found->second : nullptr;
+}
+
+static vector<Vector2Int> FindRouteStretch(int startCell, int& searchSteps) {
+    // An enemy standing on a tile that just got blocked steps onto its best walkable neighbour first
+    Vector2Int start = { startCell % gridColumns, startCell / gridColumns };
+    if (IsTileWalkable(start.x, start.y)) return FindHierarchicalPath(start, pathRefineTiles, searchSteps);
+    int dx[] = {0, 0, 1, -1};
+    int dy[] = {-1, 1, 0, 0};
+    Vector2Int best = {-1, -1};
+    for (int i = 0; i < 4; ++i) {
+        Vector2Int neighbor = {start.x + dx[i], start.y + dy[i]};
+        int distance = GetGoalDistance(neighbor);
+        if (distance >= 0 && (best.x < 0 || distance < GetGoalDistance(best))) best = neighbor;
+    }
+    searchSteps = 0;
+    if (best.x < 0) return {};
+    vector<Vector2Int> path = FindHierarchicalPath(best, pathRefineTiles, searchSteps);
+    if (!path.empty()) path.insert(path.begin(), start);
+    return path;
+}
+
+static int DeliverPath(Enemy& enemy, const vector<Vector2Int>& path) {
+    // Returns the tiles copied, which is what a delivery costs against the budget
+    if (path.empty()) return 1; // No way through; keep the current path and try again on the next check
+    // The enemy kept walking on its old path while it waited, so join the new one where it stands now
+    Vector2Int current = GetGridCoords(enemy.position);
+    for (size_t i = 0; i < path.size(); i++) {
+        if (path[i].x != current.x || path[i].y != current.y) continue;
+        // Past this tile's center already and heading where the new path goes next: do not turn back
+        if (i + 1 < path.size() && enemy.pathIndex < enemy.waypointsPath.size() &&
+            enemy.waypointsPath[enemy.pathIndex].x == path[i + 1].x && enemy.waypointsPath[enemy.pathIndex].y == path[i + 1].y) {
+            i++;
+        }
+        SetEnemyPath(enemy, i == 0 ? path : vector<Vector2Int>(path.begin() + i, path.end()));
+        return (int)(path.size() - i);
+    }
+    RequestEnemyPath(enemy);
+    return (int)path.size();
+}
+
+void ProcessPathRequests() {
+    TraceScope trace("ProcessPathRequests");
+    DropStaleFinishedPaths();
+    int stepsLeft = pathRequestStepBudget;
+    while (nextPathJob < pathJobs.size() && stepsLeft > 0) {
+        // Indexed rather than held by reference: a delivery can queue a follow-up job and grow pathJobs
+        int startCell = pathJobs[nextPathJob].startCell;
+        auto found = finishedPaths.find(startCell);
+        if (found == finishedPaths.end()) {
+            int searchSteps;
+            found = finishedPaths.emplace(startCell, FindRouteStretch(startCell, searchSteps)).first;
+            stepsLeft -= max(searchSteps, 1);
+        }
+        // Answered from the back, so a job cut short by the budget resumes where it stopped next tick
+        while (!pathJobs[nextPathJob].enemyIds.empty() && stepsLeft > 0) {
+            int enemyId = pathJobs[nextPathJob].enemyIds.back();
+            pathJobs[nextPathJob].enemyIds.pop_back();
+            Enemy* enemy = FindEnemyById(enemyId);
+            if (enemy == nullptr || !enemy->active) continue;
+            enemy->pathRequested = false;
+            stepsLeft -= DeliverPath(*enemy, found->second);
+        }
+        if (!pathJobs[nextPathJob].enemyIds.empty()) break;
+        pendingPathJobs.erase(startCell);
+        nextPathJob++;
+    }
+    if (nextPathJob == pathJobs.size()) {
+        pathJobs.clear();
+        nextPathJob = 0;
+    }
+}
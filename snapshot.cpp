@@ -0,0 +1,131 @@
+#include "game.h"
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// The simulation runs on its own thread while the main thread draws. A frame goes: input on the
+// main thread with the sim idle, StartSimulationFrame, draw the world from the front snapshot while
+// the sim runs this frame's ticks and fills the back one, FinishSimulationFrame to wait and swap,
+// then the HUD, which still reads live state. GL calls stay on the main thread, and game state is
+// only ever touched by one thread at a time.
+
+static RenderSnapshot renderSnapshots[2];
+static int frontSnapshot = 0;
+static thread simThread;
+static mutex simMutex;
+static condition_variable simWake;
+static condition_variable simDone;
+static bool simFrameRequested = false;
+static bool simFrameRunning = false;
+static bool simFrameStarted = false; // Main thread only: a frame was started and not yet finished
+static bool simThreadQuit = false;
+
+void BuildRenderSnapshot(RenderSnapshot& snapshot) {
+    TraceScope trace("BuildRenderSnapshot");
+    // Vectors are refilled in place so their capacity carries over between frames
+    snapshot.towers.clear();
+    for (const auto& tower : towers) {
+        float rotation = (float)fmod(tower.rotationSpeed * simTime, 360.0);
+        float dps = tower.isMalfunctioning ? 0.0f : GetTowerDps(tower);
+        snapshot.towers.push_back({ tower.position, tower.texture, tower.color, tower.range, rotation, tower.upgradeLevel, dps });
+    }
+    snapshot.enemies.clear();
+    for (const auto& enemy : enemies) {
+        if (!enemy.active) continue;
+        shared_ptr<const PathRoute> route = enemy.waypointsPath.empty() ? nullptr : enemy.route;
+        snapshot.enemies.push_back({ enemy.position, enemy.texture, enemy.color, (float)enemy.hp / enemy.maxHp, move(route), enemy.routeSegment });
+    }
+    static vector<Archetype*> effectArchetypes;
+    snapshot.projectiles.clear();
+    QueryArchetypes(ComponentBit(COMPONENT_POSITION) | ComponentBit(COMPONENT_PROJECTILE), effectArchetypes);
+    for (Archetype* archetype : effectArchetypes) {
+        const Vector2* positions = GetComponentColumn<Vector2>(*archetype, COMPONENT_POSITION);
+        const ProjectileComponent* projectiles = GetComponentColumn<ProjectileComponent>(*archetype, COMPONENT_PROJECTILE);
+        Projectile::Type type = (archetype->mask & ComponentBit(COMPONENT_SPLASH)) ? Projectile::Type::FLAMETHROWER : Projectile::Type::STANDARD;
+        for (size_t row = 0; row < archetype->entities.size(); row++) {
+            snapshot.projectiles.push_back({ positions[row], projectiles[row].sourcePosition, projectiles[row].texture, type });
+        }
+    }
+    snapshot.visualEffects.clear();
+    QueryArchetypes(ComponentBit(COMPONENT_POSITION) | ComponentBit(COMPONENT_LIFETIME) | ComponentBit(COMPONENT_FADING_CIRCLE), effectArchetypes);
+    for (Archetype* archetype : effectArchetypes) {
+        const Vector2* positions = GetComponentColumn<Vector2>(*archetype, COMPONENT_POSITION);
+        const LifetimeComponent* lifetimes = GetComponentColumn<LifetimeComponent>(*archetype, COMPONENT_LIFETIME);
+        const FadingCircleComponent* circles = GetComponentColumn<FadingCircleComponent>(*archetype, COMPONENT_FADING_CIRCLE);
+        for (size_t row = 0; row < archetype->entities.size(); row++) {
+            snapshot.visualEffects.push_back({ positions[row], lifetimes[row].lifespan, lifetimes[row].timer, circles[row].color, circles[row].radius, true });
+        }
+    }
+    snapshot.laserBeams.clear();
+    QueryArchetypes(ComponentBit(COMPONENT_LIFETIME) | ComponentBit(COMPONENT_BEAM), effectArchetypes);
+    for (Archetype* archetype : effectArchetypes) {
+        const LifetimeComponent* lifetimes = GetComponentColumn<LifetimeComponent>(*archetype, COMPONENT_LIFETIME);
+        const BeamComponent* beams = GetComponentColumn<BeamComponent>(*archetype, COMPONENT_BEAM);
+        for (size_t row = 0; row < archetype->entities.size(); row++) {
+            snapshot.laserBeams.push_back({ beams[row].start, beams[row].end, lifetimes[row].timer, lifetimes[row].lifespan, true, beams[row].color, beams[row].thickness });
+        }
+    }
+}
+
+const RenderSnapshot& GetRenderSnapshot() {
+    return renderSnapshots[frontSnapshot];
+}
+
+void ResetRenderSnapshots() {
+    // Called with the sim idle (game reset), so neither buffer is in use
+    for (auto& snapshot : renderSnapshots) BuildRenderSnapshot(snapshot);
+}
+
+static void RunSimulationThread() {
+    SetTraceThreadName("Simulation");
+    unique_lock<mutex> lock(simMutex);
+    while (true) {
+        simWake.wait(lock, []() { return simFrameRequested || simThreadQuit; });
+        if (simThreadQuit) return;
+        simFrameRequested = false;
+        lock.unlock();
+        BeginTraceScope("SimulationFrame");
+        RunSimulationTicks();
+        SetAllocationTag(ALLOC_SNAPSHOT);
+        BuildRenderSnapshot(renderSnapshots[1 - frontSnapshot]);
+        SetAllocationTag(ALLOC_OTHER);
+        EndTraceScope();
+        lock.lock();
+        simFrameRunning = false;
+        simDone.notify_one();
+    }
+}
+
+void StartSimulationFrame() {
+    if (!simThread.joinable()) simThread = thread(RunSimulationThread);
+    lock_guard<mutex> lock(simMutex);
+    simFrameRequested = true;
+    simFrameRunning = true;
+    simFrameStarted = true;
+    simWake.notify_one();
+}
+
+void FinishSimulationFrame() {
+    if (!simFrameStarted) return;
+    TraceScope trace("WaitForSimulation");
+    unique_lock<mutex> lock(simMutex);
+    simDone.wait(lock, []() { return !simFrameRunning; });
+    simFrameStarted = false;
+    frontSnapshot = 1 - frontSnapshot;
+}
+
+bool IsSimulationThreadRunning() {
+    return simThread.joinable();
+}
+
+void StopSimulationThread() {
+    if (!simThread.joinable()) return;
+    FinishSimulationFrame();
+    {
+        lock_guard<mutex> lock(simMutex);
+        simThreadQuit = true;
+        simWake.notify_one();
+    }
+    simThread.join();
+}
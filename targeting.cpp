@@ -0,0 +1,297 @@
+#include "game.h"
+
+// Per-tick index of active enemies bucketed by the tile they stand on.
+// Entries are sorted by cell so each grid row of a query box is one contiguous run.
+struct EnemyCellEntry {
+    int cell;
+    int enemyIndex;
+};
+
+// Per-tick index of active enemies ordered by remaining distance to the goal (leader first)
+struct EnemyProgressEntry {
+    float remaining;
+    int enemyIndex;
+};
+
+static vector<EnemyCellEntry> enemyCells;
+static vector<float> enemyCellX; // Positions parallel to enemyCells for the batched radius kernels
+static vector<float> enemyCellY;
+static vector<int> hitScratch;
+static vector<int> coverageHitScratch; // Separate from hitScratch: scoring may run radius queries mid-batch
+static vector<EnemyProgressEntry> enemyProgress;
+static int offFieldEnemyCount = 0; // Enemies whose remaining distance is not field based
+static size_t indexedEnemyCount = 0; // enemies.size() the indices cover; later spawns are not indexed yet
+static vector<int> compactedIndex;
+static vector<int> candidateScratch;
+static vector<int> neighborScratch;
+static vector<int> clusterSizeCache; // Neighbours within splash radius per indexed enemy, -1 until asked
+static vector<int> acquiringSlot; // Tower index -> slot in the current batch acquisition, -1 when not acquiring
+
+struct TargetCandidate {
+    int enemyIndex;
+    float score;
+};
+
+static vector<TargetCandidate> acquiredTargets;
+
+int GetEnemyCellIndex(Vector2 position) {
+    int col = clamp((int)(position.x / tileWidth), 0, gridColumns - 1);
+    int row = clamp((int)(position.y / tileHeight), 0, gridRows - 1);
+    return row * gridColumns + col;
+}
+
+void BuildEnemyQueryIndex() {
+    TraceScope trace("BuildEnemyQueryIndex");
+    enemyCells.clear();
+    for (int i = 0; i < (int)enemies.size(); i++) {
+        if (!enemies[i].active) continue;
+        enemyCells.push_back({ GetEnemyCellIndex(enemies[i].position), i });
+    }
+    sort(enemyCells.begin(), enemyCells.end(), [](const EnemyCellEntry& a, const EnemyCellEntry& b) {
+        return a.cell < b.cell || (a.cell == b.cell && a.enemyIndex < b.enemyIndex);
+    });
+    enemyCellX.resize(enemyCells.size());
+    enemyCellY.resize(enemyCells.size());
+    for (size_t i = 0; i < enemyCells.size(); i++) {
+        enemyCellX[i] = enemies[enemyCells[i].enemyIndex].position.x;
+        enemyCellY[i] = enemies[enemyCells[i].enemyIndex].position.y;
+    }
+    hitScratch.resize(enemyCells.size());
+    coverageHitScratch.resize(enemyCells.size());
+    indexedEnemyCount = enemies.size();
+    clusterSizeCache.assign(enemies.size(), -1);
+}
+
+void QueryEnemiesInRadius(Vector2 center, float radius, vector<int>& outIndices) {
+    outIndices.clear();
+    int minCol = clamp((int)((center.x - radius) / tileWidth), 0, gridColumns - 1);
+    int maxCol = clamp((int)((center.x + radius) / tileWidth), 0, gridColumns - 1);
+    int minRow = clamp((int)((center.y - radius) / tileHeight), 0, gridRows - 1);
+    int maxRow = clamp((int)((center.y + radius) / tileHeight), 0, gridRows - 1);
+    float radiusSq = radius * radius;
+    for (int row = minRow; row <= maxRow; row++) {
+        int firstCell = row * gridColumns + minCol;
+        int lastCell = row * gridColumns + maxCol;
+        int first = (int)(lower_bound(enemyCells.begin(), enemyCells.end(), firstCell,
+            [](const EnemyCellEntry& e, int cell) { return e.cell < cell; }) - enemyCells.begin());
+        int last = first;
+        while (last < (int)enemyCells.size() && enemyCells[last].cell <= lastCell) last++;
+        // The row's cells are one contiguous run, so test it as a single batch
+        int hits = SelectPointsInRadius(enemyCellX.data() + first, enemyCellY.data() + first, last - first, center, radius, hitScratch.data());
+        for (int h = 0; h < hits; h++) {
+            int enemyIndex = enemyCells[first + hitScratch[h]].enemyIndex;
+            if (enemies[enemyIndex].active) outIndices.push_back(enemyIndex);
+        }
+    }
+    // Enemies spawned since the index was built are not bucketed yet
+    for (size_t i = indexedEnemyCount; i < enemies.size(); i++) {
+        if (enemies[i].active && Vector2DistanceSqr(center, enemies[i].position) < radiusSq) outIndices.push_back((int)i);
+    }
+}
+
+Enemy* FindEnemyById(int id) {
+    if (id < 0) return nullptr;
+    auto it = lower_bound(enemies.begin(), enemies.end(), id, [](const Enemy& e, int value) { return e.id < value; });
+    if (it == enemies.end() || it->id != id) return nullptr;
+    return &*it;
+}
+
+const char* GetTargetingPolicyName(TargetingPolicy policy) {
+    switch (policy) {
+        case TARGET_FIRST: return "First";
+        case TARGET_STRONGEST: return "Strongest";
+        case TARGET_WEAKEST: return "Weakest";
+        case TARGET_CLOSEST: return "Closest";
+        case TARGET_CLUSTERED: return "Clustered";
+        default: return "Unknown";
+    }
+}
+
+static float GetTargetScore(const Tower& tower, int enemyIndex) {
+    // Every policy is expressed as "lower score wins"; callers break ties by the earliest-spawned enemy
+    const Enemy& enemy = enemies[enemyIndex];
+    switch (tower.targetingPolicy) {
+        case TARGET_FIRST: return GetEnemyRemainingDistance(enemy);
+        case TARGET_STRONGEST: return -(float)enemy.hp;
+        case TARGET_WEAKEST: return (float)enemy.hp;
+        case TARGET_CLUSTERED:
+            if (enemyIndex >= (int)clusterSizeCache.size() || clusterSizeCache[enemyIndex] < 0) {
+                QueryEnemiesInRadius(enemy.position, flamethrowerSplashRadius, neighborScratch);
+                if (enemyIndex >= (int)clusterSizeCache.size()) return -(float)neighborScratch.size();
+                clusterSizeCache[enemyIndex] = (int)neighborScratch.size();
+            }
+            return -(float)clusterSizeCache[enemyIndex];
+        case TARGET_CLOSEST:
+        default: return Vector2DistanceSqr(tower.position, enemy.position);
+    }
+}
+
+Enemy* AcquireTarget(const Tower& tower) {
+    QueryEnemiesInRadius(tower.position, tower.range, candidateScratch);
+    Enemy* best = nullptr;
+    float bestScore = 0.0f;
+    for (int index : candidateScratch) {
+        Enemy& enemy = enemies[index];
+        float score = GetTargetScore(tower, index);
+        if (best == nullptr || score < bestScore || (score == bestScore && enemy.id < best->id)) {
+            best = &enemy;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+void AcquireTargetsFromCoverage(const vector<int>& towerIndices) {
+    if (towerIndices.empty()) return;
+    acquiringSlot.assign(towers.size(), -1);
+    acquiredTargets.assign(towerIndices.size(), { -1, 0.0f });
+    for (int slot = 0; slot < (int)towerIndices.size(); slot++) acquiringSlot[towerIndices[slot]] = slot;
+    // Walk the enemies one occupied tile at a time and offer them only to the towers covering that tile
+    for (size_t first = 0; first < enemyCells.size();) {
+        int cell = enemyCells[first].cell;
+        size_t last = first;
+        while (last < enemyCells.size() && enemyCells[last].cell == cell) last++;
+        const vector<int>* covering = GetTowersCoveringTile({ cell % gridColumns, cell / gridColumns });
+        for (size_t c = 0; covering != nullptr && c < covering->size(); c++) {
+            int slot = acquiringSlot[(*covering)[c]];
+            if (slot < 0) continue;
+            const Tower& tower = towers[(*covering)[c]];
+            TargetCandidate& best = acquiredTargets[slot];
+            int hits = SelectPointsInRadius(enemyCellX.data() + first, enemyCellY.data() + first, (int)(last - first), tower.position, tower.range, coverageHitScratch.data());
+            for (int h = 0; h < hits; h++) {
+                int index = enemyCells[first + coverageHitScratch[h]].enemyIndex;
+                const Enemy& enemy = enemies[index];
+                if (!enemy.active) continue;
+                float score = GetTargetScore(tower, index);
+                if (best.enemyIndex < 0 || score < best.score || (score == best.score && enemy.id < enemies[best.enemyIndex].id)) {
+                    best = { index, score };
+                }
+            }
+        }
+        first = last;
+    }
+    for (int slot = 0; slot < (int)towerIndices.size(); slot++) {
+        int enemyIndex = acquiredTargets[slot].enemyIndex;
+        towers[towerIndices[slot]].targetEnemyId = enemyIndex >= 0 ? enemies[enemyIndex].id : -1;
+    }
+}
+
+void BuildEnemyProgressIndex() {
+    TraceScope trace("BuildEnemyProgressIndex");
+    enemyProgress.clear();
+    offFieldEnemyCount = 0;
+    for (int i = 0; i < (int)enemies.size(); i++) {
+        const Enemy& enemy = enemies[i];
+        if (!enemy.active) continue;
+        bool onField = !enemy.waypointsPath.empty() &&
+            GetGoalDistance(enemy.pathIndex >= enemy.waypointsPath.size() ? enemy.waypointsPath.back() : enemy.waypointsPath[enemy.pathIndex]) >= 0;
+        if (!onField) offFieldEnemyCount++;
+        enemyProgress.push_back({ GetEnemyRemainingDistance(enemy), i });
+    }
+    indexedEnemyCount = enemies.size();
+    sort(enemyProgress.begin(), enemyProgress.end(), [](const EnemyProgressEntry& a, const EnemyProgressEntry& b) {
+        return a.remaining < b.remaining || (a.remaining == b.remaining && a.enemyIndex < b.enemyIndex);
+    });
+}
+
+void ProcessEscapedEnemies() {
+    TraceScope trace("ProcessEscapedEnemies");
+    // Arrived enemies have zero remaining distance, so they sit at the front of the index
+    for (const auto& entry : enemyProgress) {
+        if (entry.remaining > 0.0f) break;
+        Enemy& enemy = enemies[entry.enemyIndex];
+        if (!enemy.active) continue;
+        enemy.active = false;
+        enemiesReachedEnd++;
+        if (enemiesReachedEnd >= maxEnemiesReachedEnd) currentState = GAME_OVER;
+    }
+}
+
+void CompactEnemies() {
+    TraceScope trace("CompactEnemies");
+    // Drop dead enemies and remap the per-tick indices so they stay usable for the draw pass
+    compactedIndex.assign(enemies.size(), -1);
+    int nextIndex = 0;
+    for (int i = 0; i < (int)enemies.size(); i++) {
+        if (enemies[i].active) compactedIndex[i] = nextIndex++;
+        else ReleaseEnemyTile(enemies[i]);
+    }
+    enemies.erase(remove_if(enemies.begin(), enemies.end(), [](const Enemy& e) { return !e.active; }), enemies.end());
+    size_t keptCells = 0;
+    for (size_t i = 0; i < enemyCells.size(); i++) {
+        int enemyIndex = compactedIndex[enemyCells[i].enemyIndex];
+        if (enemyIndex < 0) continue;
+        enemyCells[keptCells] = { enemyCells[i].cell, enemyIndex };
+        enemyCellX[keptCells] = enemyCellX[i];
+        enemyCellY[keptCells] = enemyCellY[i];
+        keptCells++;
+    }
+    enemyCells.resize(keptCells);
+    enemyCellX.resize(keptCells);
+    enemyCellY.resize(keptCells);
+    auto remapProgress = remove_if(enemyProgress.begin(), enemyProgress.end(), [](EnemyProgressEntry& e) {
+        e.enemyIndex = compactedIndex[e.enemyIndex];
+        return e.enemyIndex < 0;
+    });
+    enemyProgress.erase(remapProgress, enemyProgress.end());
+    indexedEnemyCount = enemies.size();
+}
+
+int GetAliveEnemyCount() {
+    int count = (int)(enemies.size() - indexedEnemyCount);
+    for (const auto& entry : enemyProgress) {
+        if (enemies[entry.enemyIndex].active) count++;
+    }
+    return count;
+}
+
+const Enemy* GetLeadingEnemy() {
+    for (const auto& entry : enemyProgress) {
+        if (enemies[entry.enemyIndex].active) return &enemies[entry.enemyIndex];
+    }
+    return nullptr;
+}
+
+static void UpdateTowerProgressWindow(Tower& tower) {
+    // Min/max goal distance over the tiles the range circle touches bounds the remaining
+    // distance of any enemy inside it: one tile of slack for the tile it is heading to,
+    // plus up to one tile of travel towards that tile's center
+    int minField = -1, maxField = -1;
+    int minCol = clamp((int)((tower.position.x - tower.range) / tileWidth), 0, gridColumns - 1);
+    int maxCol = clamp((int)((tower.position.x + tower.range) / tileWidth), 0, gridColumns - 1);
+    int minRow = clamp((int)((tower.position.y - tower.range) / tileHeight), 0, gridRows - 1);
+    int maxRow = clamp((int)((tower.position.y + tower.range) / tileHeight), 0, gridRows - 1);
+    for (int row = minRow; row <= maxRow; row++) {
+        for (int col = minCol; col <= maxCol; col++) {
+            float nearestX = clamp(tower.position.x, (float)(col * tileWidth), (float)((col + 1) * tileWidth));
+            float nearestY = clamp(tower.position.y, (float)(row * tileHeight), (float)((row + 1) * tileHeight));
+            if (Vector2DistanceSqr(tower.position, { nearestX, nearestY }) > tower.range * tower.range) continue;
+            int field = GetGoalDistance({ col, row });
+            if (field < 0) continue;
+            if (minField < 0 || field < minField) minField = field;
+            if (field > maxField) maxField = field;
+        }
+    }
+    if (minField < 0) {
+        tower.progressWindowMin = 1.0f;
+        tower.progressWindowMax = 0.0f;
+    } else {
+        tower.progressWindowMin = (float)(minField - 1) * tileWidth;
+        tower.progressWindowMax = (float)(maxField + 1) * tileWidth + (float)max(tileWidth, tileHeight);
+    }
+    tower.progressWindowVersion = gridVersion;
+}
+
+Enemy* FindLeadingEnemyInRange(Tower& tower) {
+    if (tower.progressWindowVersion != gridVersion) UpdateTowerProgressWindow(tower);
+    // Binary search to the tower's band, then walk forward until the first enemy actually in range
+    auto it = lower_bound(enemyProgress.begin(), enemyProgress.end(), tower.progressWindowMin,
+        [](const EnemyProgressEntry& e, float value) { return e.remaining < value; });
+    float rangeSq = tower.range * tower.range;
+    for (; it != enemyProgress.end() && it->remaining <= tower.progressWindowMax; ++it) {
+        Enemy& enemy = enemies[it->enemyIndex];
+        if (enemy.active && Vector2DistanceSqr(tower.position, enemy.position) < rangeSq) return &enemy;
+    }
+    if (offFieldEnemyCount > 0) return AcquireTarget(tower);
+    return nullptr;
+}
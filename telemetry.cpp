@@ -0,0 +1,249 @@
+#include "game.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// Combat telemetry, enabled with --telemetry <file.csv>. The sim side only writes a small event
+// into a ring buffer; a writer thread drains it, folds the events into per-tower counters and
+// appends one CSV row per tower when a wave ends. Events come from the sim thread and from input
+// handling on the main thread, but the two never run at once (the sim frame handshake orders
+// them), so the ring has a single producer at any time and needs no lock. A full ring drops
+// events rather than stalling the sim; the count is reported when telemetry stops.
+
+enum TelemetryEventType : uint8_t {
+    TELEMETRY_SHOT,
+    TELEMETRY_DAMAGE,
+    TELEMETRY_TOWER_PLACED,
+    TELEMETRY_TOWER_UPGRADED,
+    TELEMETRY_MALFUNCTION_START,
+    TELEMETRY_MALFUNCTION_END,
+    TELEMETRY_WAVE_START,
+    TELEMETRY_WAVE_END,
+    TELEMETRY_RESET
+};
+
+struct TelemetryEvent {
+    double time; // simTime
+    int32_t tower;
+    int32_t amount; // Damage, money spent, or the wave index
+    int32_t overkill;
+    uint8_t type;
+    uint8_t source; // DamageSource for damage, TowerType for placement
+    uint8_t upgradeLevel;
+};
+
+// Writer-side running totals for one tower over the current wave
+struct TowerTelemetry {
+    TowerType type;
+    int upgradeLevel;
+    int invested;
+    double placedTime;
+    double malfunctionStart; // -1 while working
+    double malfunctionTime;
+    int shots;
+    int hits;
+    long long damage[DAMAGE_SOURCE_COUNT];
+    int kills;
+    long long overkill;
+};
+
+static vector<TelemetryEvent> telemetryRing;
+static atomic<uint32_t> telemetryHead(0); // Next slot the producer writes
+static atomic<uint32_t> telemetryTail(0); // Next slot the writer reads
+static atomic<uint64_t> droppedTelemetryEvents(0);
+static atomic<bool> telemetryQuit(false);
+static bool telemetryEnabled = false;
+static thread telemetryWriter;
+static FILE* telemetryFile = nullptr;
+
+// Writer thread only
+static vector<TowerTelemetry> towerTelemetry;
+static bool telemetryWaveOpen = false;
+static int telemetryWave = 0;
+static double telemetryWaveStart = 0.0;
+static double lastTelemetryTime = 0.0;
+
+static void PushTelemetryEvent(const TelemetryEvent& event) {
+    uint32_t head = telemetryHead.load(memory_order_relaxed);
+    if (head - telemetryTail.load(memory_order_acquire) >= (uint32_t)telemetryRingCapacity) {
+        droppedTelemetryEvents.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    telemetryRing[head & (telemetryRingCapacity - 1)] = event;
+    telemetryHead.store(head + 1, memory_order_release);
+}
+
+void RecordTowerShot(int towerIndex) {
+    if (!telemetryEnabled) return;
+    PushTelemetryEvent({ simTime, towerIndex, 0, 0, TELEMETRY_SHOT, 0, 0 });
+}
+
+void RecordTowerDamage(int towerIndex, DamageSource source, int damage, int hpAfter) {
+    // hpAfter <= 0 is a kill; whatever went past zero is overkill
+    if (!telemetryEnabled) return;
+    PushTelemetryEvent({ simTime, towerIndex, damage, hpAfter <= 0 ? -hpAfter : -1, TELEMETRY_DAMAGE, (uint8_t)source, 0 });
+}
+
+void RecordTowerPlaced(int towerIndex) {
+    if (!telemetryEnabled) return;
+    const Tower& tower = towers[towerIndex];
+    PushTelemetryEvent({ simTime, towerIndex, GetTowerCost(tower.type), 0, TELEMETRY_TOWER_PLACED, (uint8_t)tower.type, (uint8_t)tower.upgradeLevel });
+}
+
+void RecordTowerUpgraded(int towerIndex, int cost) {
+    if (!telemetryEnabled) return;
+    PushTelemetryEvent({ simTime, towerIndex, cost, 0, TELEMETRY_TOWER_UPGRADED, 0, (uint8_t)towers[towerIndex].upgradeLevel });
+}
+
+void RecordTowerMalfunction(int towerIndex, bool malfunctioning) {
+    if (!telemetryEnabled) return;
+    PushTelemetryEvent({ simTime, towerIndex, 0, 0, (uint8_t)(malfunctioning ? TELEMETRY_MALFUNCTION_START : TELEMETRY_MALFUNCTION_END), 0, 0 });
+}
+
+void RecordWaveStart(int waveIndex) {
+    if (!telemetryEnabled) return;
+    PushTelemetryEvent({ simTime, -1, waveIndex, 0, TELEMETRY_WAVE_START, 0, 0 });
+}
+
+void RecordWaveEnd(int waveIndex) {
+    if (!telemetryEnabled) return;
+    PushTelemetryEvent({ simTime, -1, waveIndex, 0, TELEMETRY_WAVE_END, 0, 0 });
+}
+
+void RecordTelemetryReset() {
+    // Tower indices start over after a reset
+    if (!telemetryEnabled) return;
+    PushTelemetryEvent({ simTime, -1, 0, 0, TELEMETRY_RESET, 0, 0 });
+}
+
+static double GetWaveMalfunctionTime(const TowerTelemetry& stats, double until) {
+    if (!telemetryWaveOpen || stats.malfunctionStart < 0.0) return 0.0;
+    return max(0.0, until - max(stats.malfunctionStart, telemetryWaveStart));
+}
+
+static void ClearTowerCounters(TowerTelemetry& stats) {
+    stats.malfunctionTime = 0.0;
+    stats.shots = 0;
+    stats.hits = 0;
+    for (auto& damage : stats.damage) damage = 0;
+    stats.kills = 0;
+    stats.overkill = 0;
+}
+
+static void WriteWaveRows(double endTime) {
+    if (!telemetryWaveOpen) return;
+    for (size_t i = 0; i < towerTelemetry.size(); i++) {
+        TowerTelemetry& stats = towerTelemetry[i];
+        double malfunction = stats.malfunctionTime + GetWaveMalfunctionTime(stats, endTime);
+        double uptime = max(0.0, endTime - max(stats.placedTime, telemetryWaveStart) - malfunction);
+        fprintf(telemetryFile, "%d,%zu,%s,%d,%d,%d,%d,%lld,%lld,%lld,%lld,%d,%lld,%.2f,%.2f\n", telemetryWave + 1, i,
+                GetTowerName(stats.type), stats.upgradeLevel, stats.invested, stats.shots, stats.hits,
+                stats.damage[DAMAGE_DIRECT], stats.damage[DAMAGE_LASER], stats.damage[DAMAGE_SPLASH], stats.damage[DAMAGE_BURN],
+                stats.kills, stats.overkill, uptime, malfunction);
+        ClearTowerCounters(stats);
+    }
+    fflush(telemetryFile);
+    telemetryWaveOpen = false;
+}
+
+static void ApplyTelemetryEvent(const TelemetryEvent& event) {
+    lastTelemetryTime = event.time;
+    if (event.tower >= (int)towerTelemetry.size() && event.type != TELEMETRY_TOWER_PLACED) return;
+    switch (event.type) {
+        case TELEMETRY_SHOT:
+            towerTelemetry[event.tower].shots++;
+            break;
+        case TELEMETRY_DAMAGE: {
+            TowerTelemetry& stats = towerTelemetry[event.tower];
+            if (event.source != DAMAGE_BURN) stats.hits++;
+            stats.damage[event.source] += event.amount;
+            if (event.overkill >= 0) {
+                stats.kills++;
+                stats.overkill += event.overkill;
+            }
+            break;
+        }
+        case TELEMETRY_TOWER_PLACED: {
+            if (event.tower >= (int)towerTelemetry.size()) towerTelemetry.resize(event.tower + 1);
+            TowerTelemetry& stats = towerTelemetry[event.tower];
+            stats = {};
+            stats.type = (TowerType)event.source;
+            stats.upgradeLevel = event.upgradeLevel;
+            stats.invested = event.amount;
+            stats.placedTime = event.time;
+            stats.malfunctionStart = -1.0;
+            break;
+        }
+        case TELEMETRY_TOWER_UPGRADED:
+            towerTelemetry[event.tower].upgradeLevel = event.upgradeLevel;
+            towerTelemetry[event.tower].invested += event.amount;
+            break;
+        case TELEMETRY_MALFUNCTION_START:
+            towerTelemetry[event.tower].malfunctionStart = event.time;
+            break;
+        case TELEMETRY_MALFUNCTION_END: {
+            TowerTelemetry& stats = towerTelemetry[event.tower];
+            stats.malfunctionTime += GetWaveMalfunctionTime(stats, event.time);
+            stats.malfunctionStart = -1.0;
+            break;
+        }
+        case TELEMETRY_WAVE_START:
+            for (auto& stats : towerTelemetry) ClearTowerCounters(stats);
+            telemetryWaveOpen = true;
+            telemetryWave = event.amount;
+            telemetryWaveStart = event.time;
+            break;
+        case TELEMETRY_WAVE_END:
+            WriteWaveRows(event.time);
+            break;
+        case TELEMETRY_RESET:
+            // A wave cut short by a loss or a restart still gets its rows
+            WriteWaveRows(event.time);
+            towerTelemetry.clear();
+            break;
+    }
+}
+
+static void RunTelemetryWriter() {
+    while (true) {
+        // Read the quit flag first so everything pushed before it was set is drained below
+        bool quit = telemetryQuit.load(memory_order_acquire);
+        uint32_t tail = telemetryTail.load(memory_order_relaxed);
+        uint32_t head = telemetryHead.load(memory_order_acquire);
+        for (; tail != head; tail++) ApplyTelemetryEvent(telemetryRing[tail & (telemetryRingCapacity - 1)]);
+        telemetryTail.store(tail, memory_order_release);
+        if (quit) break;
+        this_thread::sleep_for(chrono::milliseconds(telemetryWriterIntervalMs));
+    }
+    WriteWaveRows(lastTelemetryTime);
+}
+
+bool StartTelemetry(const string& path) {
+    telemetryFile = fopen(path.c_str(), "w");
+    if (telemetryFile == nullptr) {
+        TraceLog(LOG_WARNING, "TELEMETRY: Cannot write %s", path.c_str());
+        return false;
+    }
+    fprintf(telemetryFile, "wave,tower,type,level,invested,shots,hits,direct,laser,splash,burn,kills,overkill,uptime,malfunction\n");
+    telemetryRing.resize(telemetryRingCapacity);
+    telemetryEnabled = true;
+    telemetryWriter = thread(RunTelemetryWriter);
+    return true;
+}
+
+bool IsTelemetryRunning() {
+    return telemetryWriter.joinable();
+}
+
+void StopTelemetry() {
+    // Called after the sim thread has stopped, so no more events can arrive
+    if (!telemetryWriter.joinable()) return;
+    telemetryQuit.store(true, memory_order_release);
+    telemetryWriter.join();
+    telemetryEnabled = false;
+    uint64_t dropped = droppedTelemetryEvents.load(memory_order_relaxed);
+    if (dropped > 0) TraceLog(LOG_WARNING, "TELEMETRY: %llu events dropped with the ring full", (unsigned long long)dropped);
+    fclose(telemetryFile);
+    telemetryFile = nullptr;
+}
@@ -4,18 +4,24 @@ Tower CreateTower(TowerType type, Vector2 position) {
     Tower newTower;
     newTower.position = position;
     newTower.type = type;
-    newTower.fireCooldown = 0.0f;
-    newTower.rotationAngle = 0.0f;
+    newTower.nextFireTime = 0.0;
     newTower.rotationSpeed = 0.0f;
     newTower.texture = { 0 };
     newTower.projectileTexture = { 0 };
     newTower.upgradeLevel = 0;
-    newTower.abilityCooldownTimer = 0.0f;
+    newTower.abilityReadyTime = 0.0;
     newTower.abilityActive = false;
-    newTower.abilityTimer = 0.0f;
+    newTower.abilityEndTime = 0.0;
     newTower.isPowerShotActive = false;
     newTower.lastFiredTime = 0.0f;
     newTower.isMalfunctioning = false;
+    newTower.targetingPolicy = TARGET_CLOSEST;
+    newTower.targetEnemyId = -1;
+    newTower.progressWindowMin = 0.0f;
+    newTower.progressWindowMax = 0.0f;
+    newTower.progressWindowVersion = -1;
+    newTower.coveredEnemyCount = 0;
+    newTower.awakeSlot = -1;
     switch (type) {
         case TIER1_DEFAULT:
             newTower.color = BLUE;
@@ -128,48 +134,78 @@ void ApplyTowerUpgrade(Tower& tower) {
     }
 }
 
+// Ability expiry and HARD malfunctions are the only timed tower events. They wait in a min-heap
+// keyed by simTime, so idle towers cost nothing per tick
+enum TowerDeadlineType { DEADLINE_ABILITY_END, DEADLINE_MALFUNCTION };
+
+struct TowerDeadline {
+    double time;
+    int towerIndex;
+    TowerDeadlineType type;
+};
+
+struct LaterDeadline {
+    bool operator()(const TowerDeadline& a, const TowerDeadline& b) const {
+        return a.time > b.time || (a.time == b.time && a.towerIndex > b.towerIndex);
+    }
+};
+
+static priority_queue<TowerDeadline, vector<TowerDeadline>, LaterDeadline> towerDeadlines;
+
+static void ScheduleTowerDeadline(int towerIndex, TowerDeadlineType type, double time) {
+    towerDeadlines.push({ time, towerIndex, type });
+}
+
+static void ScheduleTowerMalfunction(int towerIndex) {
+    if (currentDifficulty != HARD) return;
+    ScheduleTowerDeadline(towerIndex, DEADLINE_MALFUNCTION, towers[towerIndex].lastFiredTime + towerMalfunctionDelay);
+}
+
+void RebuildTowerTileIndex() {
+    towerAtTile.assign((size_t)gridColumns * gridRows, -1);
+    for (int i = 0; i < (int)towers.size(); i++) {
+        Vector2Int tile = GetGridCoords(towers[i].position);
+        if (IsInsideGrid(tile.x, tile.y)) towerAtTile[tile.y * gridColumns + tile.x] = i;
+    }
+}
+
+int GetTowerAtTile(Vector2Int gridCoords) {
+    if (!IsInsideGrid(gridCoords.x, gridCoords.y)) return -1;
+    return towerAtTile[gridCoords.y * gridColumns + gridCoords.x];
+}
+
+float GetTowerDps(const Tower& tower) {
+    // Sustained damage against unarmoured enemies, matching what HandleTowerFiring deals per shot
+    if (tower.upgradeLevel == 2 && tower.type == TIER1_DEFAULT) return tower.damage / 0.2f;
+    if (tower.upgradeLevel == 2 && tower.type == TIER2_FAST) return (tower.damage / 3 + 8 * (tower.damage / 8)) * tower.fireRate;
+    return tower.damage * tower.fireRate;
+}
+
+bool PlaceTower(TowerType type, Vector2Int tile) {
+    // Shared by mouse placement and the agent API; a rejected placement changes nothing
+    if (type <= NONE || type >= TOWER_TYPE_COUNT) return false;
+    if (!IsInsideGrid(tile.x, tile.y) || !IsTileWalkable(tile.x, tile.y) || WouldBlockRoute(tile)) return false;
+    int cost = GetTowerCost(type);
+    if (GetTowerAtTile(tile) >= 0 || playerMoney < cost) return false;
+    Tower newTower = CreateTower(type, { (float)(tile.x * tileWidth + tileWidth / 2), (float)(tile.y * tileHeight + tileHeight / 2) });
+    towerAtTile[tile.y * gridColumns + tile.x] = (int)towers.size();
+    towers.push_back(newTower);
+    AddTowerCoverage((int)towers.size() - 1);
+    ScheduleTowerMalfunction((int)towers.size() - 1);
+    RecordTowerPlaced((int)towers.size() - 1);
+    playerMoney -= cost;
+    SetTileWalkable(tile.x, tile.y, false); // Mark grid cell as occupied
+    NotifyTileBlocked(tile);
+    // Queue path recalculation for the enemies headed through the new tower
+    RequestPathsThroughTile(tile);
+    return true;
+}
+
 void HandleTowerPlacement() {
+    TraceScope trace("HandleTowerPlacement");
     if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && selectedTowerType != NONE) {
-        Vector2 mousePos = GetMousePosition();
-        int gridCol = mousePos.x / tileWidth;
-        int gridRow = mousePos.y / tileHeight;
-        if (gridCol >= 0 && gridCol < gridColumns && gridRow >= 0 && gridRow < gridRows && grid[gridRow][gridCol]) {
-            bool towerAlreadyExists = false;
-            for (const auto& tower : towers) {
-                int towerGridCol = tower.position.x / tileWidth;
-                int towerGridRow = tower.position.y / tileHeight;
-                if (towerGridCol == gridCol && towerGridRow == gridRow) {
-                    towerAlreadyExists = true;
-                    break;
-                }
-            }
-            int cost = GetTowerCost(selectedTowerType);
-            if (!towerAlreadyExists && playerMoney >= cost) {
-                Tower newTower = CreateTower(selectedTowerType, { (float)(gridCol * tileWidth + tileWidth / 2), (float)(gridRow * tileHeight + tileHeight / 2) });
-                towers.push_back(newTower);
-                playerMoney -= cost;
-                grid[gridRow][gridCol] = false; // Mark grid cell as occupied
-                selectedTowerType = NONE;
-                
-                // Immediately force path recalculation for all enemies
-                Vector2Int endGrid = GetGridCoords(waypoints[waypoints.size()-1]);
-                for (auto& enemy : enemies) {
-                    if (enemy.active) {
-                        Vector2Int startGrid = GetGridCoords(enemy.position);
-                        vector<Vector2Int> newPath = FindPathBFS(startGrid, endGrid);
-                        if (!newPath.empty()) {
-                            enemy.waypointsPath = newPath;
-                            enemy.pathIndex = 0;
-                            enemy.pathCheckTimer = 0.0f; // Reset the timer
-                        }
-                    }
-                }
-            } else {
-                selectedTowerType = NONE;
-            }
-        } else {
-            selectedTowerType = NONE;
-        }
+        PlaceTower(selectedTowerType, GetGridCoords(GetMouseWorldPosition()));
+        selectedTowerType = NONE;
     }
 }
 
@@ -187,42 +223,51 @@ bool IsMouseOverTowerUI() {
 void HandleTowerSelection() {
     if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
         if (IsMouseOverTowerUI()) return;
-        Vector2 mousePos = GetMousePosition();
-        selectedTowerIndex = -1;
-        for (int i = 0; i < towers.size(); i++) {
-            float distance = Vector2Distance(mousePos, towers[i].position);
-            if (distance <= tileWidth / 2.0f) {
-                selectedTowerIndex = i;
-                break;
-            }
-        }
+        selectedTowerIndex = GetTowerAtTile(GetGridCoords(GetMouseWorldPosition()));
     }
 }
 
+static Rectangle GetUpgradeButtonRect() {
+    return { (float)selectedTowerInfoX, (float)(selectedTowerInfoY + infoSpacing * 6), (float)upgradeButtonWidth, (float)upgradeButtonHeight };
+}
+
+static bool CanUpgradeTower(const Tower& tower) {
+    return tower.upgradeLevel < 2 && playerMoney >= GetTowerUpgradeCost(tower.type, tower.upgradeLevel);
+}
+
+bool UpgradeTower(int towerIndex) {
+    if (towerIndex < 0 || towerIndex >= (int)towers.size() || !CanUpgradeTower(towers[towerIndex])) return false;
+    Tower& tower = towers[towerIndex];
+    int upgradeCost = GetTowerUpgradeCost(tower.type, tower.upgradeLevel);
+    playerMoney -= upgradeCost;
+    RemoveTowerCoverage(towerIndex);
+    tower.upgradeLevel++;
+    ApplyTowerUpgrade(tower);
+    RecordTowerUpgraded(towerIndex, upgradeCost);
+    AddTowerCoverage(towerIndex);
+    tower.progressWindowVersion = -1;
+    return true;
+}
+
 void HandleTowerUpgrade() {
-    if (selectedTowerIndex >= 0 && selectedTowerIndex < towers.size()) {
-        Tower& selectedTower = towers[selectedTowerIndex];
-        int upgradeCost = GetTowerUpgradeCost(selectedTower.type, selectedTower.upgradeLevel);
-        Rectangle upgradeButton = { (float)selectedTowerInfoX, (float)(selectedTowerInfoY + infoSpacing * 6), (float)upgradeButtonWidth, (float)upgradeButtonHeight };
-        bool canUpgrade = (selectedTower.upgradeLevel < 2) && (playerMoney >= upgradeCost);
-        Color buttonColor = canUpgrade ? GREEN : GRAY;
-        DrawRectangleRec(upgradeButton, buttonColor);
-        DrawRectangleLinesEx(upgradeButton, 2.0f, BLACK);
-        DrawText(TextFormat("Upgrade: $%d", upgradeCost), selectedTowerInfoX + 10, selectedTowerInfoY + infoSpacing * 6 + 10, 20, BLACK);
-        if (canUpgrade && IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(GetMousePosition(), upgradeButton)) {
-            playerMoney -= upgradeCost;
-            selectedTower.upgradeLevel++;
-            ApplyTowerUpgrade(selectedTower);
-        }
+    if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(GetMousePosition(), GetUpgradeButtonRect())) {
+        UpgradeTower(selectedTowerIndex);
     }
 }
 
-void DrawTowers() {
-    Vector2 mousePos = GetMousePosition();
-    for (int i = 0; i < towers.size(); i++) {
-        const auto& tower = towers[i];
-        float distanceToMouse = Vector2Distance(mousePos, tower.position);
-        bool isHovered = distanceToMouse <= tileWidth / 2.0f;
+void DrawTowerUpgradeButton(const Tower& tower) {
+    Rectangle upgradeButton = GetUpgradeButtonRect();
+    DrawRectangleRec(upgradeButton, CanUpgradeTower(tower) ? GREEN : GRAY);
+    DrawRectangleLinesEx(upgradeButton, 2.0f, BLACK);
+    DrawText(TextFormat("Upgrade: $%d", GetTowerUpgradeCost(tower.type, tower.upgradeLevel)), selectedTowerInfoX + 10, selectedTowerInfoY + infoSpacing * 6 + 10, 20, BLACK);
+}
+
+void DrawTowers(const RenderSnapshot& snapshot) {
+    TraceScope trace("DrawTowers");
+    int hoveredTowerIndex = GetTowerAtTile(GetGridCoords(GetMouseWorldPosition()));
+    for (int i = 0; i < snapshot.towers.size(); i++) {
+        const auto& tower = snapshot.towers[i];
+        bool isHovered = (i == hoveredTowerIndex);
         bool isSelected = (i == selectedTowerIndex);
         if (isSelected || isHovered) {
             Color rangeColor = isSelected ? GOLD : tower.color;
@@ -240,7 +285,7 @@ void DrawTowers() {
             Rectangle sourceRec = { 0.0f, 0.0f, (float)tower.texture.width, (float)tower.texture.height };
             Rectangle destRec = { tower.position.x, tower.position.y, (float)tileWidth, (float)tileHeight };
             Vector2 origin = { (float)tileWidth / 2.0f, (float)tileHeight / 2.0f };
-            DrawTexturePro(tower.texture, sourceRec, destRec, origin, tower.rotationAngle, WHITE);
+            DrawTexturePro(tower.texture, sourceRec, destRec, origin, tower.rotation, WHITE);
             if (tower.upgradeLevel > 0) {
                 for (int lvl = 0; lvl < tower.upgradeLevel; lvl++) {
                     DrawCircle(tower.position.x - 10 + lvl * 10, tower.position.y - tileHeight / 2 - 5, 3, GOLD);
@@ -257,86 +302,110 @@ void DrawTowers() {
     }
 }
 
+static bool HasTargetInRange(const Tower& tower, Enemy*& target) {
+    target = FindEnemyById(tower.targetEnemyId);
+    return target != nullptr && target->active && Vector2DistanceSqr(tower.position, target->position) < tower.range * tower.range;
+}
+
 void HandleTowerFiring() {
-    for (auto& tower : towers) {
-        if (tower.isMalfunctioning) continue;
-        if (tower.fireCooldown > 0.0f) {
-            tower.fireCooldown -= GetFrameTime();
-            continue;
+    TraceScope trace("HandleTowerFiring");
+    static vector<int> readyTowers;
+    static vector<int> acquiringTowers;
+    readyTowers.clear();
+    acquiringTowers.clear();
+    // Dormant towers (no enemy on any tile they cover) cannot have a target, so only awake ones
+    // are visited; sorting keeps the firing order of the full tower list
+    static vector<int> awakeTowers;
+    awakeTowers = GetAwakeTowers();
+    sort(awakeTowers.begin(), awakeTowers.end());
+    for (int i : awakeTowers) {
+        Tower& tower = towers[i];
+        if (tower.isMalfunctioning || tower.nextFireTime > simTime) continue;
+        readyTowers.push_back(i);
+        // Keep the cached target while it is alive and in range; only a lost target triggers acquisition
+        Enemy* target = nullptr;
+        if (HasTargetInRange(tower, target)) continue;
+        if (tower.targetingPolicy == TARGET_FIRST) {
+            target = FindLeadingEnemyInRange(tower);
+            tower.targetEnemyId = target != nullptr ? target->id : -1;
+        } else {
+            acquiringTowers.push_back(i);
         }
+    }
+    AcquireTargetsFromCoverage(acquiringTowers);
+
+    for (int towerIndex : readyTowers) {
+        Tower& tower = towers[towerIndex];
+        // A target can die to an earlier tower this tick; re-acquire on its own in that case.
+        // An id of -1 means acquisition already found nothing in range
         Enemy* target = nullptr;
-        float minDistance = tower.range;
-        for (auto& enemy : enemies) {
-            if (!enemy.active) continue;
-            float distance = Vector2Distance(tower.position, enemy.position);
-            if (distance < minDistance) {
-                minDistance = distance;
-                target = &enemy;
-            }
+        if (!HasTargetInRange(tower, target) && tower.targetEnemyId >= 0) {
+            target = tower.targetingPolicy == TARGET_FIRST ? FindLeadingEnemyInRange(tower) : AcquireTarget(tower);
+            tower.targetEnemyId = target != nullptr ? target->id : -1;
         }
         if (target != nullptr) {
+            RecordTowerShot(towerIndex);
             if (tower.upgradeLevel == 2) {
                 if (tower.type == TIER1_DEFAULT) {
                     int actualDamage = tower.damage;
                     if (target->type == ARMOURED_ENEMY || target->type == FAST_ARMOURED_ENEMY) actualDamage = (int)(actualDamage * 0.7f);
                     target->hp -= actualDamage;
+                    RecordTowerDamage(towerIndex, DAMAGE_LASER, actualDamage, target->hp);
                     if (target->hp <= 0) {
                         target->active = false;
                         playerMoney += 10;
                         defeatedEnemies++;
                     }
-                    LaserBeam laser = { tower.position, target->position, 0.1f, 0.1f, true, ColorAlpha(SKYBLUE, 0.8f), 2.0f };
-                    laserBeams.push_back(laser);
-                    VisualEffect impactEffect = { target->position, 0.2f, 0.2f, ColorAlpha(WHITE, 0.9f), 8.0f, true };
-                    visualEffects.push_back(impactEffect);
-                    tower.fireCooldown = 0.2f;
+                    SpawnLaserBeam({ tower.position, target->position, 0.1f, 0.1f, true, ColorAlpha(SKYBLUE, 0.8f), 2.0f });
+                    SpawnVisualEffect({ target->position, 0.2f, 0.2f, ColorAlpha(WHITE, 0.9f), 8.0f, true });
+                    tower.nextFireTime = simTime + 0.2f;
                 } else if (tower.type == TIER2_FAST) {
-                    Projectile newProjectile = { tower.position, target, 150.0f, tower.damage, true, tower.projectileTexture, Projectile::Type::FLAMETHROWER, tower.position, 50.0f };
-                    projectiles.push_back(newProjectile);
-                    tower.fireCooldown = 1.0f / tower.fireRate;
+                    Projectile newProjectile = { tower.position, target->id, 150.0f, tower.damage, true, tower.projectileTexture, Projectile::Type::FLAMETHROWER, tower.position, flamethrowerSplashRadius, towerIndex };
+                    SpawnProjectile(newProjectile);
+                    tower.nextFireTime = simTime + 1.0f / tower.fireRate;
                 } else {
                     int projectileDamage = tower.isPowerShotActive && tower.type == TIER3_STRONG ? tower.damage * 3 : tower.damage;
                     if (tower.isPowerShotActive) tower.isPowerShotActive = false;
-                    Projectile newProjectile = { tower.position, target, 200.0f, projectileDamage, true, tower.projectileTexture, Projectile::Type::STANDARD, tower.position, 0.0f };
-                    projectiles.push_back(newProjectile);
-                    tower.fireCooldown = 1.0f / tower.fireRate;
+                    Projectile newProjectile = { tower.position, target->id, 200.0f, projectileDamage, true, tower.projectileTexture, Projectile::Type::STANDARD, tower.position, 0.0f, towerIndex };
+                    SpawnProjectile(newProjectile);
+                    tower.nextFireTime = simTime + 1.0f / tower.fireRate;
                 }
             } else {
                 int projectileDamage = tower.isPowerShotActive && tower.type == TIER3_STRONG ? tower.damage * 3 : tower.damage;
                 if (tower.isPowerShotActive) tower.isPowerShotActive = false;
-                Projectile newProjectile = { tower.position, target, 200.0f, projectileDamage, true, tower.projectileTexture, Projectile::Type::STANDARD, tower.position, 0.0f };
-                projectiles.push_back(newProjectile);
-                tower.fireCooldown = 1.0f / tower.fireRate;
+                Projectile newProjectile = { tower.position, target->id, 200.0f, projectileDamage, true, tower.projectileTexture, Projectile::Type::STANDARD, tower.position, 0.0f, towerIndex };
+                SpawnProjectile(newProjectile);
+                tower.nextFireTime = simTime + 1.0f / tower.fireRate;
             }
             VisualEffect fireEffect = { tower.position, 0.2f, 0.2f, ColorAlpha(tower.type == TIER1_DEFAULT ? SKYBLUE : tower.type == TIER2_FAST ? LIME : RED, 0.8f),
                 (tower.isPowerShotActive && tower.type == TIER3_STRONG) ? 25.0f : (tower.type == TIER2_FAST && tower.upgradeLevel == 2) ? 20.0f : (tower.type == TIER1_DEFAULT && tower.upgradeLevel == 2) ? 18.0f : 15.0f, true };
             if (tower.isPowerShotActive && tower.type == TIER3_STRONG) fireEffect.color = ColorAlpha(ORANGE, 0.9f);
             else if (tower.type == TIER2_FAST && tower.upgradeLevel == 2) fireEffect.color = ColorAlpha(ORANGE, 0.8f);
             else if (tower.type == TIER1_DEFAULT && tower.upgradeLevel == 2) fireEffect.color = ColorAlpha(SKYBLUE, 0.9f);
-            visualEffects.push_back(fireEffect);
-            tower.lastFiredTime = GetTime();
+            SpawnVisualEffect(fireEffect);
+            tower.lastFiredTime = (float)simTime;
         }
     }
 }
 
 void ActivateTowerAbility(Tower& tower) {
-    if (tower.abilityCooldownTimer > 0.0f || tower.abilityActive) return;
-    tower.abilityCooldownTimer = tower.abilityCooldownDuration;
+    static vector<int> slowedEnemies;
+    if (tower.abilityReadyTime > simTime || tower.abilityActive) return;
+    tower.abilityReadyTime = simTime + tower.abilityCooldownDuration;
     switch (tower.type) {
         case TIER1_DEFAULT:
             tower.abilityActive = true;
-            tower.abilityTimer = tower.abilityDuration;
-            for (auto& enemy : enemies) {
-                if (enemy.active && Vector2Distance(tower.position, enemy.position) <= tower.range) {
-                    enemy.isSlowed = true;
-                    enemy.slowTimer = tower.abilityDuration;
-                    enemy.speed = enemy.originalSpeed * 0.5f;
-                }
+            tower.abilityEndTime = simTime + tower.abilityDuration;
+            ScheduleTowerDeadline((int)(&tower - towers.data()), DEADLINE_ABILITY_END, tower.abilityEndTime);
+            QueryEnemiesInRadius(tower.position, tower.range, slowedEnemies);
+            for (int enemyIndex : slowedEnemies) {
+                ApplyEnemySlow(enemies[enemyIndex], tower.abilityDuration);
             }
             break;
         case TIER2_FAST:
             tower.abilityActive = true;
-            tower.abilityTimer = tower.abilityDuration;
+            tower.abilityEndTime = simTime + tower.abilityDuration;
+            ScheduleTowerDeadline((int)(&tower - towers.data()), DEADLINE_ABILITY_END, tower.abilityEndTime);
             tower.originalFireRate = tower.fireRate;
             tower.fireRate *= 1.5f;
             break;
@@ -347,38 +416,96 @@ void ActivateTowerAbility(Tower& tower) {
     }
 }
 
+static Rectangle GetAbilityButtonRect() {
+    return { (float)selectedTowerInfoX, (float)(selectedTowerInfoY + infoSpacing * 8), (float)abilityButtonWidth, (float)abilityButtonHeight };
+}
+
+static Rectangle GetTargetingButtonRect() {
+    return { (float)selectedTowerInfoX, (float)(selectedTowerInfoY + infoSpacing * 5), (float)upgradeButtonWidth, (float)targetingButtonHeight };
+}
+
 void HandleTowerAbilityButton() {
     if (selectedTowerIndex >= 0 && selectedTowerIndex < towers.size()) {
         Tower& selectedTower = towers[selectedTowerIndex];
-        Rectangle abilityButton = { (float)selectedTowerInfoX, (float)(selectedTowerInfoY + infoSpacing * 8), (float)abilityButtonWidth, (float)abilityButtonHeight };
-        bool canActivate = (selectedTower.abilityCooldownTimer <= 0.0f && !selectedTower.abilityActive);
-        Color buttonColor = canActivate ? BLUE : GRAY;
-        const char* buttonText = selectedTower.abilityActive ? TextFormat("Active: %.1fs", selectedTower.abilityTimer) :
-                               selectedTower.abilityCooldownTimer > 0.0f ? TextFormat("Cooldown: %.1fs", selectedTower.abilityCooldownTimer) : "Activate Ability";
-        DrawRectangleRec(abilityButton, buttonColor);
-        DrawRectangleLinesEx(abilityButton, 2.0f, BLACK);
-        int textWidth = MeasureText(buttonText, 18);
-        int textX = selectedTowerInfoX + (abilityButtonWidth - textWidth) / 2;
-        DrawText(buttonText, textX, selectedTowerInfoY + infoSpacing * 8 + 10, 18, WHITE);
-        DrawText(selectedTower.type == TIER1_DEFAULT ? "Area Slow (3s)" : selectedTower.type == TIER2_FAST ? "Speed Boost (5s)" : "Power Shot (3x DMG)",
-                 selectedTowerInfoX, selectedTowerInfoY + infoSpacing * 7, 16, BLACK);
-        if (canActivate && IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(GetMousePosition(), abilityButton)) {
+        bool canActivate = (selectedTower.abilityReadyTime <= simTime && !selectedTower.abilityActive);
+        if (canActivate && IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(GetMousePosition(), GetAbilityButtonRect())) {
             ActivateTowerAbility(selectedTower);
         }
     }
 }
 
+void DrawTowerAbilityButton(const Tower& tower) {
+    Rectangle abilityButton = GetAbilityButtonRect();
+    bool canActivate = (tower.abilityReadyTime <= simTime && !tower.abilityActive);
+    const char* buttonText = tower.abilityActive ? TextFormat("Active: %.1fs", tower.abilityEndTime - simTime) :
+                           tower.abilityReadyTime > simTime ? TextFormat("Cooldown: %.1fs", tower.abilityReadyTime - simTime) : "Activate Ability";
+    DrawRectangleRec(abilityButton, canActivate ? BLUE : GRAY);
+    DrawRectangleLinesEx(abilityButton, 2.0f, BLACK);
+    int textWidth = MeasureText(buttonText, 18);
+    int textX = selectedTowerInfoX + (abilityButtonWidth - textWidth) / 2;
+    DrawText(buttonText, textX, selectedTowerInfoY + infoSpacing * 8 + 10, 18, WHITE);
+    DrawText(tower.type == TIER1_DEFAULT ? "Area Slow (3s)" : tower.type == TIER2_FAST ? "Speed Boost (5s)" : "Power Shot (3x DMG)",
+             selectedTowerInfoX, selectedTowerInfoY + infoSpacing * 7, 16, BLACK);
+}
+
+void HandleTargetingPolicyButton() {
+    if (selectedTowerIndex >= 0 && selectedTowerIndex < towers.size()) {
+        Tower& selectedTower = towers[selectedTowerIndex];
+        if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT) && CheckCollisionPointRec(GetMousePosition(), GetTargetingButtonRect())) {
+            selectedTower.targetingPolicy = (TargetingPolicy)((selectedTower.targetingPolicy + 1) % TARGETING_POLICY_COUNT);
+            selectedTower.targetEnemyId = -1;
+        }
+    }
+}
+
+void DrawTargetingPolicyButton(const Tower& tower) {
+    Rectangle targetingButton = GetTargetingButtonRect();
+    DrawRectangleRec(targetingButton, DARKBLUE);
+    DrawRectangleLinesEx(targetingButton, 2.0f, BLACK);
+    DrawText(TextFormat("Target: %s", GetTargetingPolicyName(tower.targetingPolicy)), selectedTowerInfoX + 6, selectedTowerInfoY + infoSpacing * 5 + 4, 16, WHITE);
+}
+
 void RepairTower(Tower& tower) {
     if (tower.isMalfunctioning && playerMoney >= 50) {
         playerMoney -= 50;
         tower.isMalfunctioning = false;
-        tower.lastFiredTime = GetTime();
+        tower.lastFiredTime = (float)simTime;
+        RecordTowerMalfunction((int)(&tower - towers.data()), false);
+        ScheduleTowerMalfunction((int)(&tower - towers.data()));
         if (tower.type == TIER1_DEFAULT) tower.color = BLUE;
         else if (tower.type == TIER2_FAST) tower.color = GREEN;
         else if (tower.type == TIER3_STRONG) tower.color = RED;
     }
 }
 
+void ResetTowerDeadlines() {
+    towerDeadlines = {};
+    for (int i = 0; i < (int)towers.size(); i++) ScheduleTowerMalfunction(i);
+}
+
+void ProcessTowerDeadlines() {
+    TraceScope trace("ProcessTowerDeadlines");
+    while (!towerDeadlines.empty() && towerDeadlines.top().time <= simTime) {
+        TowerDeadline deadline = towerDeadlines.top();
+        towerDeadlines.pop();
+        Tower& tower = towers[deadline.towerIndex];
+        if (deadline.type == DEADLINE_ABILITY_END) {
+            if (!tower.abilityActive || tower.abilityEndTime > simTime) continue;
+            tower.abilityActive = false;
+            if (tower.type == TIER2_FAST) tower.fireRate = tower.originalFireRate;
+        } else if (!tower.isMalfunctioning && tower.type != NONE) {
+            // Firing pushes the deadline back without touching the heap; re-arm lazily when it comes due
+            if (simTime >= tower.lastFiredTime + towerMalfunctionDelay) {
+                tower.isMalfunctioning = true;
+                tower.color = GRAY;
+                RecordTowerMalfunction(deadline.towerIndex, true);
+            } else {
+                ScheduleTowerMalfunction(deadline.towerIndex);
+            }
+        }
+    }
+}
+
 void DrawTowerTooltip(TowerType type, Vector2 position) {
     Vector2 mousePos = GetMousePosition();
     Rectangle tier1Rec = { (float)towerMenuStartX, (float)towerMenuStartY, (float)towerSelectionWidth, (float)towerSelectionHeight };
@@ -390,12 +517,16 @@ void DrawTowerTooltip(TowerType type, Vector2 position) {
     else if (CheckCollisionPointRec(mousePos, tier3Rec) && type == TIER3_STRONG) tooltipShown = true;
     if (!tooltipShown) return;
 
-    Tower dummyTower = CreateTower(type, {0, 0});
-    int tooltipWidth = 200, tooltipHeight = 150, padding = 10, fontSize = 15, lineHeight = fontSize + 2;
     float tooltipX = position.x + 20;
     if (tooltipX + tooltipWidth > screenWidth) tooltipX = screenWidth - tooltipWidth - 5;
     float tooltipY = position.y;
     if (tooltipY + tooltipHeight > screenHeight) tooltipY = screenHeight - tooltipHeight - 5;
+    DrawCachedTooltip(type, { tooltipX, tooltipY });
+}
+
+void DrawTowerTooltipPanel(TowerType type, float tooltipX, float tooltipY) {
+    Tower dummyTower = CreateTower(type, {0, 0});
+    int padding = 10, fontSize = 15, lineHeight = fontSize + 2;
     DrawRectangle(tooltipX, tooltipY, tooltipWidth, tooltipHeight, ColorAlpha(LIGHTGRAY, 0.9f));
     DrawRectangleLinesEx((Rectangle){tooltipX, tooltipY, (float)tooltipWidth, (float)tooltipHeight}, 2, BLACK);
     int textY = tooltipY + padding;
@@ -0,0 +1,138 @@
+#include "game.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+// Timeline capture in the Chrome trace-event format (open in chrome://tracing or Perfetto).
+// Scopes are timed on the thread that runs them and appended to that thread's own buffer, so
+// recording takes no lock. F4 starts a capture and F4 again writes it; --trace <file.json> captures
+// from launch and writes on exit. Buffers are only read between frames, when the sim thread is
+// idle. Outside a capture a scope costs a flag check and a push onto its thread's scope stack.
+
+struct TraceEvent {
+    const char* name;
+    double start;    // Microseconds since the capture started
+    double duration;
+};
+
+struct OpenTraceScope {
+    const char* name;
+    double start; // -1 when the scope opened outside a capture
+};
+
+struct ThreadTraceBuffer {
+    int threadId;
+    const char* threadName;
+    vector<TraceEvent> events;
+    vector<OpenTraceScope> openScopes;
+};
+
+static vector<unique_ptr<ThreadTraceBuffer>> traceBuffers;
+static mutex traceBuffersMutex; // Guards registration only
+static thread_local ThreadTraceBuffer* threadTraceBuffer = nullptr;
+static atomic<bool> traceCapturing(false);
+static atomic<uint64_t> droppedTraceEvents(0);
+static chrono::steady_clock::time_point traceStartTime;
+static string traceOutputPath = traceFileName;
+
+static double GetTraceMicroseconds() {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - traceStartTime).count();
+}
+
+static ThreadTraceBuffer& GetThreadTraceBuffer() {
+    if (threadTraceBuffer == nullptr) {
+        lock_guard<mutex> lock(traceBuffersMutex);
+        auto buffer = make_unique<ThreadTraceBuffer>();
+        buffer->threadId = (int)traceBuffers.size() + 1;
+        buffer->threadName = "Worker";
+        threadTraceBuffer = buffer.get();
+        traceBuffers.push_back(move(buffer));
+    }
+    return *threadTraceBuffer;
+}
+
+void SetTraceThreadName(const char* name) {
+    GetThreadTraceBuffer().threadName = name;
+}
+
+void BeginTraceScope(const char* name) {
+    double start = traceCapturing.load(memory_order_relaxed) ? GetTraceMicroseconds() : -1.0;
+    GetThreadTraceBuffer().openScopes.push_back({ name, start });
+}
+
+void EndTraceScope() {
+    ThreadTraceBuffer& buffer = GetThreadTraceBuffer();
+    if (buffer.openScopes.empty()) return;
+    OpenTraceScope scope = buffer.openScopes.back();
+    buffer.openScopes.pop_back();
+    if (scope.start < 0.0 || !traceCapturing.load(memory_order_relaxed)) return;
+    if ((int)buffer.events.size() >= traceMaxEventsPerThread) {
+        droppedTraceEvents.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    buffer.events.push_back({ scope.name, scope.start, GetTraceMicroseconds() - scope.start });
+}
+
+TraceScope::TraceScope(const char* name) {
+    BeginTraceScope(name);
+}
+
+TraceScope::~TraceScope() {
+    EndTraceScope();
+}
+
+void StartTraceCapture() {
+    lock_guard<mutex> lock(traceBuffersMutex);
+    for (auto& buffer : traceBuffers) buffer->events.clear();
+    droppedTraceEvents.store(0, memory_order_relaxed);
+    traceStartTime = chrono::steady_clock::now();
+    traceCapturing.store(true, memory_order_relaxed);
+    TraceLog(LOG_INFO, "TRACE: Capturing");
+}
+
+static bool WriteTraceFile(const string& path) {
+    FILE* file = fopen(path.c_str(), "w");
+    if (file == nullptr) {
+        TraceLog(LOG_WARNING, "TRACE: Cannot write %s", path.c_str());
+        return false;
+    }
+    // Scope names are string literals, so nothing needs escaping
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    size_t eventCount = 0;
+    for (const auto& buffer : traceBuffers) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", buffer->threadId, buffer->threadName);
+        first = false;
+        for (const auto& event : buffer->events) {
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    event.name, buffer->threadId, event.start, event.duration);
+        }
+        eventCount += buffer->events.size();
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+    TraceLog(LOG_INFO, "TRACE: Wrote %zu events to %s", eventCount, path.c_str());
+    return true;
+}
+
+void StopTraceCapture() {
+    // Only called between frames (or after the sim thread stopped), so no thread is recording
+    if (!traceCapturing.load(memory_order_relaxed)) return;
+    traceCapturing.store(false, memory_order_relaxed);
+    lock_guard<mutex> lock(traceBuffersMutex);
+    uint64_t dropped = droppedTraceEvents.load(memory_order_relaxed);
+    if (dropped > 0) TraceLog(LOG_WARNING, "TRACE: %llu events dropped with the buffers full", (unsigned long long)dropped);
+    WriteTraceFile(traceOutputPath);
+}
+
+void SetTraceOutputPath(const string& path) {
+    traceOutputPath = path;
+}
+
+void HandleTraceCapture() {
+    if (!IsKeyPressed(KEY_F4)) return;
+    if (traceCapturing.load(memory_order_relaxed)) StopTraceCapture();
+    else StartTraceCapture();
+}
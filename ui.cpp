@@ -0,0 +1,137 @@
+#include "game.h"
+#include "rlgl.h"
+#include <cmath>
+#include <cstring>
+
+// The HUD (status text, tower menu, selected tower panel, wave progress) is drawn into a render
+// texture and only redrawn when one of the values it shows changes, so an ordinary frame costs a
+// single blit instead of formatting and measuring every string again. Tooltips are cached the
+// same way per tower type, since only their position follows the mouse.
+
+// Everything the HUD shows, reduced to the precision it is printed at. All ints, so two states
+// can be compared with memcmp
+struct HudState {
+    int money;
+    int escaped;
+    int waveInProgress;
+    int waveIndex;
+    int hasWave;
+    int nextWaveSeconds;
+    int selectedTowerType;
+    int spawned;
+    int defeated;
+    int total;
+    int alive;
+    int towerIndex;
+    int towerType;
+    int towerDamage;
+    int towerRange;
+    int towerFireRateTenths;
+    int towerLevel;
+    int towerPolicy;
+    int towerMalfunctioning;
+    int abilityState;
+    int abilityTenths;
+};
+
+static RenderTexture2D hudLayer;
+static bool hudLayerLoaded = false;
+static HudState hudLayerState;
+static RenderTexture2D tooltipLayer;
+static TowerType tooltipLayerType = NONE;
+
+static HudState CaptureHudState() {
+    HudState state;
+    memset(&state, 0, sizeof(state));
+    state.money = playerMoney;
+    state.escaped = enemiesReachedEnd;
+    state.waveInProgress = waveInProgress;
+    state.waveIndex = currentWaveIndex;
+    state.hasWave = HasWave(currentWaveIndex);
+    state.nextWaveSeconds = waveInProgress ? 0 : (int)waveDelay + 1;
+    state.selectedTowerType = selectedTowerType;
+    state.spawned = spawnedEnemies;
+    state.defeated = defeatedEnemies;
+    state.total = currentTimeline.totalCount;
+    state.alive = GetAliveEnemyCount();
+    state.towerIndex = -1;
+    if (selectedTowerIndex >= 0 && selectedTowerIndex < towers.size()) {
+        const Tower& tower = towers[selectedTowerIndex];
+        state.towerIndex = selectedTowerIndex;
+        state.towerType = tower.type;
+        state.towerDamage = tower.damage;
+        state.towerRange = (int)lroundf(tower.range);
+        state.towerFireRateTenths = (int)lroundf(tower.fireRate * 10.0f);
+        state.towerLevel = tower.upgradeLevel;
+        state.towerPolicy = tower.targetingPolicy;
+        state.towerMalfunctioning = tower.isMalfunctioning;
+        // The ability button counts down in tenths of a second, which is as often as it can change
+        if (tower.abilityActive) {
+            state.abilityState = 1;
+            state.abilityTenths = (int)lround((tower.abilityEndTime - simTime) * 10.0);
+        } else if (tower.abilityReadyTime > simTime) {
+            state.abilityState = 2;
+            state.abilityTenths = (int)lround((tower.abilityReadyTime - simTime) * 10.0);
+        }
+    }
+    return state;
+}
+
+static void BeginUiLayer(const RenderTexture2D& layer) {
+    BeginTextureMode(layer);
+    ClearBackground(BLANK);
+    // Colour is stored premultiplied and alpha accumulated separately, so translucent panels keep
+    // the same look when the layer is blitted as when they were drawn straight to the screen
+    rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+    BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+}
+
+static void EndUiLayer() {
+    EndBlendMode();
+    EndTextureMode();
+}
+
+static void BlitUiLayer(const RenderTexture2D& layer, Vector2 position) {
+    // Render textures are stored bottom-up, hence the negative source height
+    Rectangle source = { 0.0f, 0.0f, (float)layer.texture.width, -(float)layer.texture.height };
+    BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+    DrawTextureRec(layer.texture, source, position, WHITE);
+    EndBlendMode();
+}
+
+void DrawCachedHud() {
+    TraceScope trace("DrawCachedHud");
+    HudState state = CaptureHudState();
+    if (!hudLayerLoaded) {
+        hudLayer = LoadRenderTexture(screenWidth, screenHeight);
+        hudLayerLoaded = true;
+    } else if (memcmp(&state, &hudLayerState, sizeof(state)) == 0) {
+        BlitUiLayer(hudLayer, { 0.0f, 0.0f });
+        DrawWaveLeaderMarker();
+        return;
+    }
+    hudLayerState = state;
+    BeginUiLayer(hudLayer);
+    DrawHud();
+    EndUiLayer();
+    BlitUiLayer(hudLayer, { 0.0f, 0.0f });
+    DrawWaveLeaderMarker();
+}
+
+void DrawCachedTooltip(TowerType type, Vector2 position) {
+    if (tooltipLayerType == NONE) tooltipLayer = LoadRenderTexture(tooltipWidth, tooltipHeight);
+    if (tooltipLayerType != type) {
+        tooltipLayerType = type;
+        BeginUiLayer(tooltipLayer);
+        DrawTowerTooltipPanel(type, 0.0f, 0.0f);
+        EndUiLayer();
+    }
+    BlitUiLayer(tooltipLayer, position);
+}
+
+void UnloadUiLayers() {
+    if (hudLayerLoaded) UnloadRenderTexture(hudLayer);
+    if (tooltipLayerType != NONE) UnloadRenderTexture(tooltipLayer);
+    hudLayerLoaded = false;
+    tooltipLayerType = NONE;
+}
@@ -8,44 +8,68 @@ Vector2 GetTileCenter(Vector2Int gridCoords) {
     return { (float)(gridCoords.x * tileWidth + tileWidth / 2), (float)(gridCoords.y * tileHeight + tileHeight / 2) };
 }
 
-struct GridCell {
-    Vector2Int coords;
-    Vector2Int parentCoords;
-    int distance;
-};
+void InitTileGrid(int columns, int rows) {
+    gridColumns = columns;
+    gridRows = rows;
+    grid.columns = columns;
+    grid.rows = rows;
+    grid.chunkColumns = (columns + gridChunkSize - 1) / gridChunkSize;
+    int chunkRows = (rows + gridChunkSize - 1) / gridChunkSize;
+    grid.chunks.assign(grid.chunkColumns * chunkRows, ~0ULL);
+    ResetPathClusters();
+}
+
+void SetTileWalkable(int col, int row, bool walkable) {
+    uint64_t& chunk = grid.chunks[(row / gridChunkSize) * grid.chunkColumns + col / gridChunkSize];
+    uint64_t bit = 1ULL << ((row % gridChunkSize) * gridChunkSize + col % gridChunkSize);
+    if (walkable) chunk |= bit;
+    else chunk &= ~bit;
+    MarkPathClustersDirty(col, row);
+}
+
+// Scratch buffers reused across searches; a cell counts as visited only when its stamp matches
+static vector<int> bfsVisitStamp;
+static vector<int> bfsParent;
+static vector<int> bfsQueue;
+static int bfsStamp = 0;
 
 vector<Vector2Int> FindPathBFS(Vector2Int start, Vector2Int end) {
-    if (!grid[end.y][end.x]) return {};
-    queue<GridCell> cellQueue;
-    map<pair<int, int>, bool> visited;
-    cellQueue.push({start, {-1, -1}, 0});
-    visited[{start.x, start.y}] = true;
-    map<pair<int, int>, Vector2Int> parentMap;
-    while (!cellQueue.empty()) {
-        GridCell currentCell = cellQueue.front();
-        cellQueue.pop();
-        if (currentCell.coords.x == end.x && currentCell.coords.y == end.y) {
+    if (!IsTileWalkable(end.x, end.y)) return {};
+    int cellCount = gridRows * gridColumns;
+    if ((int)bfsVisitStamp.size() != cellCount) {
+        bfsVisitStamp.assign(cellCount, 0);
+        bfsParent.assign(cellCount, -1);
+        bfsQueue.resize(cellCount);
+        bfsStamp = 0;
+    }
+    bfsStamp++;
+    int startCell = start.y * gridColumns + start.x;
+    int endCell = end.y * gridColumns + end.x;
+    int head = 0, tail = 0;
+    bfsQueue[tail++] = startCell;
+    bfsVisitStamp[startCell] = bfsStamp;
+    bfsParent[startCell] = -1;
+    int dx[] = {0, 0, 1, -1};
+    int dy[] = {-1, 1, 0, 0};
+    while (head < tail) {
+        int currentCell = bfsQueue[head++];
+        if (currentCell == endCell) {
             vector<Vector2Int> path;
-            Vector2Int currentCoords = currentCell.coords;
-            while (currentCoords.x != -1 && currentCoords.y != -1) {
-                path.push_back(currentCoords);
-                auto it = parentMap.find({currentCoords.x, currentCoords.y});
-                if (it == parentMap.end()) break;
-                currentCoords = it->second;
+            for (int cell = currentCell; cell != -1; cell = bfsParent[cell]) {
+                path.push_back({ cell % gridColumns, cell / gridColumns });
             }
             reverse(path.begin(), path.end());
             return path;
         }
-        int dx[] = {0, 0, 1, -1};
-        int dy[] = {-1, 1, 0, 0};
+        int x = currentCell % gridColumns, y = currentCell / gridColumns;
         for (int i = 0; i < 4; ++i) {
-            Vector2Int neighborCoords = {currentCell.coords.x + dx[i], currentCell.coords.y + dy[i]};
-            if (neighborCoords.x >= 0 && neighborCoords.x < gridColumns && neighborCoords.y >= 0 && neighborCoords.y < gridRows &&
-                grid[neighborCoords.y][neighborCoords.x] && !visited[{neighborCoords.x, neighborCoords.y}]) {
-                cellQueue.push({neighborCoords, currentCell.coords, currentCell.distance + 1});
-                visited[{neighborCoords.x, neighborCoords.y}] = true;
-                parentMap[{neighborCoords.x, neighborCoords.y}] = currentCell.coords;
-            }
+            int nx = x + dx[i], ny = y + dy[i];
+            if (!IsInsideGrid(nx, ny) || !IsTileWalkable(nx, ny)) continue;
+            int neighborCell = ny * gridColumns + nx;
+            if (bfsVisitStamp[neighborCell] == bfsStamp) continue;
+            bfsVisitStamp[neighborCell] = bfsStamp;
+            bfsParent[neighborCell] = currentCell;
+            bfsQueue[tail++] = neighborCell;
         }
     }
     return {};
@@ -59,4 +83,147 @@ void DrawPath(const vector<Vector2Int>& path, Color color) {
             DrawLineV(GetTileCenter(path[i]), GetTileCenter(path[i + 1]), ColorAlpha(color, 0.5f));
         }
     }
-}
\ No newline at end of file
+}
+
+void BuildGoalDistanceField() {
+    // BFS outward from the goal tile; each walkable tile gets its step count to the goal, -1 if cut off
+    goalDistanceField.assign(gridRows * gridColumns, -1);
+    Vector2Int goal = GetMapGoalTile();
+    if (!IsTileWalkable(goal.x, goal.y)) return;
+    queue<Vector2Int> cellQueue;
+    goalDistanceField[goal.y * gridColumns + goal.x] = 0;
+    cellQueue.push(goal);
+    int dx[] = {0, 0, 1, -1};
+    int dy[] = {-1, 1, 0, 0};
+    while (!cellQueue.empty()) {
+        Vector2Int current = cellQueue.front();
+        cellQueue.pop();
+        int currentDistance = goalDistanceField[current.y * gridColumns + current.x];
+        for (int i = 0; i < 4; ++i) {
+            Vector2Int neighbor = {current.x + dx[i], current.y + dy[i]};
+            if (!IsInsideGrid(neighbor.x, neighbor.y)) continue;
+            if (!IsTileWalkable(neighbor.x, neighbor.y) || goalDistanceField[neighbor.y * gridColumns + neighbor.x] >= 0) continue;
+            goalDistanceField[neighbor.y * gridColumns + neighbor.x] = currentDistance + 1;
+            cellQueue.push(neighbor);
+        }
+    }
+}
+
+int GetGoalDistance(Vector2Int gridCoords) {
+    if (!IsInsideGrid(gridCoords.x, gridCoords.y)) return -1;
+    if (goalDistanceField.empty()) return -1;
+    return goalDistanceField[gridCoords.y * gridColumns + gridCoords.x];
+}
+
+vector<Vector2Int> FindPathToGoal(Vector2Int start) {
+    // Walk down the goal distance field: O(path length) instead of a fresh search per enemy
+    if (!IsInsideGrid(start.x, start.y)) return {};
+    int dx[] = {0, 0, 1, -1};
+    int dy[] = {-1, 1, 0, 0};
+    vector<Vector2Int> path;
+    Vector2Int current = start;
+    if (GetGoalDistance(current) < 0) {
+        // Standing on a tile that just got blocked: step onto the best walkable neighbour first
+        Vector2Int best = {-1, -1};
+        for (int i = 0; i < 4; ++i) {
+            Vector2Int neighbor = {current.x + dx[i], current.y + dy[i]};
+            int distance = GetGoalDistance(neighbor);
+            if (distance >= 0 && (best.x < 0 || distance < GetGoalDistance(best))) best = neighbor;
+        }
+        if (best.x < 0) return {};
+        path.push_back(current);
+        current = best;
+    }
+    path.push_back(current);
+    for (int distance = GetGoalDistance(current); distance > 0; --distance) {
+        for (int i = 0; i < 4; ++i) {
+            Vector2Int neighbor = {current.x + dx[i], current.y + dy[i]};
+            if (GetGoalDistance(neighbor) == distance - 1) {
+                current = neighbor;
+                break;
+            }
+        }
+        path.push_back(current);
+    }
+    return path;
+}
+
+// Scratch for RepairGoalDistanceField: (cell, old distance) of the tiles checked for a stale distance
+static vector<pair<int, int>> staleTiles;
+
+void RepairGoalDistanceField(Vector2Int blockedTile) {
+    // Blocking a tile can only lengthen routes, and only for tiles whose every shortest step ran
+    // through it. Those are found by walking outward from the tile in distance order and dropping
+    // each one left without a neighbour one step closer; the hole is then filled back in from its
+    // untouched rim. Cost follows the tiles that changed, not the map
+    int blockedCell = blockedTile.y * gridColumns + blockedTile.x;
+    int blockedDistance = goalDistanceField[blockedCell];
+    goalDistanceField[blockedCell] = -1;
+    if (blockedDistance < 0) return;
+    int dx[] = {0, 0, 1, -1};
+    int dy[] = {-1, 1, 0, 0};
+    auto hasCloserNeighbor = [&](int cell, int distance) {
+        for (int i = 0; i < 4; ++i) {
+            int nx = cell % gridColumns + dx[i], ny = cell / gridColumns + dy[i];
+            if (IsInsideGrid(nx, ny) && goalDistanceField[ny * gridColumns + nx] == distance - 1) return true;
+        }
+        return false;
+    };
+    // Stale tiles are appended in distance order, so a tile's closer neighbours are settled before it
+    // is checked. A tile can be queued twice; the second visit finds it already dropped or still held
+    staleTiles.clear();
+    staleTiles.push_back({ blockedCell, blockedDistance });
+    for (size_t next = 0; next < staleTiles.size(); next++) {
+        auto [cell, distance] = staleTiles[next];
+        if (next > 0) {
+            if (goalDistanceField[cell] != distance || hasCloserNeighbor(cell, distance)) continue;
+            goalDistanceField[cell] = -1;
+        }
+        for (int i = 0; i < 4; ++i) {
+            int nx = cell % gridColumns + dx[i], ny = cell / gridColumns + dy[i];
+            if (IsInsideGrid(nx, ny) && goalDistanceField[ny * gridColumns + nx] == distance + 1) staleTiles.push_back({ ny * gridColumns + nx, distance + 1 });
+        }
+    }
+
+    // Refill: each dropped tile starts from its best surviving neighbour, then the hole is settled
+    // cheapest first, since the rim tiles start at different distances
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> frontier;
+    for (size_t i = 1; i < staleTiles.size(); i++) {
+        int cell = staleTiles[i].first;
+        if (goalDistanceField[cell] >= 0) continue;
+        int best = -1;
+        for (int direction = 0; direction < 4; ++direction) {
+            int nx = cell % gridColumns + dx[direction], ny = cell / gridColumns + dy[direction];
+            if (!IsInsideGrid(nx, ny)) continue;
+            int distance = goalDistanceField[ny * gridColumns + nx];
+            if (distance >= 0 && (best < 0 || distance + 1 < best)) best = distance + 1;
+        }
+        if (best >= 0) frontier.push({ best, cell });
+    }
+    while (!frontier.empty()) {
+        auto [distance, cell] = frontier.top();
+        frontier.pop();
+        int current = goalDistanceField[cell];
+        if (current >= 0 && current <= distance) continue;
+        goalDistanceField[cell] = distance;
+        for (int i = 0; i < 4; ++i) {
+            int nx = cell % gridColumns + dx[i], ny = cell / gridColumns + dy[i];
+            if (!IsInsideGrid(nx, ny) || !IsTileWalkable(nx, ny)) continue;
+            int neighbor = goalDistanceField[ny * gridColumns + nx];
+            if (neighbor < 0 || neighbor > distance + 1) frontier.push({ distance + 1, ny * gridColumns + nx });
+        }
+    }
+}
+
+void NotifyGridChanged() {
+    // A whole new grid: build everything now rather than on the first path request of the sim
+    gridVersion++;
+    BuildGoalDistanceField();
+    RebuildDirtyClusters();
+}
+
+void NotifyTileBlocked(Vector2Int gridCoords) {
+    // A placement: the tile is already marked unwalkable, so only the distances behind it change
+    gridVersion++;
+    RepairGoalDistanceField(gridCoords);
+}
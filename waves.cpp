@@ -0,0 +1,86 @@
+#include "game.h"
+#include <cmath>
+#include <random>
+
+// A wave is compiled once when it starts into runs of one enemy type, so spawning never re-sums the
+// counts and memory stays a handful of runs however large the wave is. Spawn k of a wave is due at
+// waveStartTime + k * spawnInterval, and every spawn that has come due is emitted on the same tick.
+
+SpawnTimeline currentTimeline;
+bool endlessMode = false;
+uint32_t endlessSeed = 1;
+
+SpawnTimeline CompileWave(const EnemyWave& wave) {
+    SpawnTimeline timeline = {};
+    timeline.spawnInterval = wave.spawnInterval;
+    const pair<EnemyType, int> counts[] = {
+        { BASIC_ENEMY, wave.basicCount }, { FAST_ENEMY, wave.fastCount },
+        { ARMOURED_ENEMY, wave.armouredCount }, { FAST_ARMOURED_ENEMY, wave.fastArmouredCount },
+    };
+    for (const auto& count : counts) {
+        if (count.second <= 0) continue;
+        timeline.totalCount += count.second;
+        timeline.runs.push_back({ count.first, timeline.totalCount });
+    }
+    return timeline;
+}
+
+bool HasWave(int index) {
+    return endlessMode || index < (int)waves.size();
+}
+
+EnemyWave GetWaveDefinition(int index) {
+    // Endless waves past the authored list are derived from the seed and index alone, so nothing is
+    // generated before it is needed and a seed always replays the same run
+    if (index < (int)waves.size()) return waves[index];
+    int endlessIndex = index - (int)waves.size();
+    mt19937 rng(endlessSeed ^ (uint32_t)(endlessIndex + 1) * 2654435761u);
+    uniform_real_distribution<float> jitter(0.5f, 1.5f);
+    int total = (int)min(20.0 * pow(1.3, endlessIndex), (double)maxEndlessWaveEnemies);
+    // Tougher types take a growing share as the waves go on
+    float weights[4] = { max(1.0f, 10.0f - endlessIndex) * jitter(rng), 3.0f * jitter(rng),
+                         endlessIndex * 0.5f * jitter(rng), endlessIndex * 0.25f * jitter(rng) };
+    float weightSum = weights[0] + weights[1] + weights[2] + weights[3];
+    EnemyWave wave = {};
+    wave.fastCount = (int)(total * weights[1] / weightSum);
+    wave.armouredCount = (int)(total * weights[2] / weightSum);
+    wave.fastArmouredCount = (int)(total * weights[3] / weightSum);
+    wave.basicCount = total - wave.fastCount - wave.armouredCount - wave.fastArmouredCount;
+    // Waves get a little longer but far denser, ending up many spawns per tick
+    wave.spawnInterval = (20.0f + 2.0f * endlessIndex) / total;
+    return wave;
+}
+
+void StartWave(int index) {
+    currentTimeline = CompileWave(GetWaveDefinition(index));
+    waveStartTime = simTime;
+    spawnedEnemies = 0;
+    defeatedEnemies = 0;
+    RecordWaveStart(index);
+}
+
+void SpawnDueEnemies() {
+    TraceScope trace("SpawnDueEnemies");
+    const SpawnTimeline& timeline = currentTimeline;
+    int due = timeline.totalCount;
+    if (timeline.spawnInterval > 0.0f) {
+        // The small epsilon keeps a spawn that lands exactly on a tick from slipping to the next one
+        double elapsed = simTime - waveStartTime + 1e-9;
+        due = (int)min((double)timeline.totalCount, floor(elapsed / timeline.spawnInterval) + 1.0);
+    }
+    if (spawnedEnemies >= due) return;
+    Vector2 spawnPoint = GetSpawnPoint();
+    auto run = timeline.runs.begin();
+    for (; spawnedEnemies < due; spawnedEnemies++) {
+        while (spawnedEnemies >= run->endIndex) ++run;
+        enemies.push_back(CreateEnemy(run->type, spawnPoint));
+        Enemy& e = enemies.back();
+        if (currentDifficulty == MEDIUM) {
+            e.maxHp = (int)(e.maxHp * 1.2f);
+            e.hp = e.maxHp;
+        } else if (currentDifficulty == HARD) {
+            e.maxHp = (int)(e.maxHp * 1.4f);
+            e.hp = e.maxHp;
+        }
+    }
+}